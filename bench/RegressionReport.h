@@ -0,0 +1,66 @@
+#pragma once
+
+//the regression bench's results and their JSON, kept apart from the timed workloads so make check can round-trip them
+//one case per line: the baseline is read back by finding a case's line and a key on it, not by a JSON parser
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "SnakeSim.h"
+
+struct CaseResult {
+    std::string name;
+    BoardSize board;
+    int snakes = 1;
+    long long ticks = 0;
+    double seconds = 0;
+    long long allocations = 0;
+    long long snakeMoves = 0;
+    bool framed = false;
+    double frameP50 = 0, frameP99 = 0, frameMax = 0; //ns
+
+    double ticksPerSecond() const { return ticks / seconds; }
+    double nsPerTick() const { return seconds * 1e9 / ticks; }
+    double allocationsPerTick() const { return double(allocations) / ticks; }
+};
+
+inline std::string toJson(const std::vector<CaseResult>& results, bool allocationFree) {
+    std::string json = "{\n  \"benchmark\": \"snake-regression\",\n  \"version\": 1,\n  \"cases\": [\n";
+    char line[512];
+
+    for (size_t i = 0; i < results.size(); i++) { //one case per line, baselineValue reads them back that way
+        const CaseResult& r = results[i];
+        snprintf(line, sizeof(line),
+            "    {\"name\": \"%s\", \"board\": \"%dx%d\", \"snakes\": %d, \"ticks\": %lld, \"seconds\": %.6f, "
+            "\"ticks_per_sec\": %.0f, \"ns_per_tick\": %.2f, \"snake_moves_per_sec\": %.0f, \"allocs_per_tick\": %.6f",
+            r.name.c_str(), r.board.rows, r.board.cols, r.snakes, r.ticks, r.seconds,
+            r.ticksPerSecond(), r.nsPerTick(), r.snakeMoves / r.seconds, r.allocationsPerTick());
+        json += line;
+
+        if (r.framed) {
+            snprintf(line, sizeof(line), ", \"frame_p50_ns\": %.0f, \"frame_p99_ns\": %.0f, \"frame_max_ns\": %.0f", r.frameP50, r.frameP99, r.frameMax);
+            json += line;
+        }
+        json += i + 1 < results.size() ? "},\n" : "}\n";
+    }
+
+    json += "  ],\n  \"allocation_free\": ";
+    json += allocationFree ? "true" : "false";
+    json += "\n}\n";
+    return json;
+}
+
+inline double baselineValue(const std::string& baseline, const CaseResult& result, const char* key) {
+    //key's number on the case's line, 0 when the case is new, ran another tick count or lacks the key
+    size_t at = baseline.find("{\"name\": \"" + result.name + "\"");
+    if (at == std::string::npos) return 0;
+    std::string line = baseline.substr(at, baseline.find('\n', at) - at);
+
+    if (line.find("\"ticks\": " + std::to_string(result.ticks) + ",") == std::string::npos) return 0; //short runs are not comparable
+    std::string field = std::string("\"") + key + "\": ";
+    size_t value = line.find(field);
+    return value == std::string::npos ? 0 : atof(line.c_str() + value + field.size());
+}
@@ -0,0 +1,245 @@
+//microbenchmarks for the simulation hot paths: move, self-collision, border check and apple spawn, plus snapshots
+//each is timed across snake lengths (2 -> full board) and board sizes (16x16 -> 1024x1024)
+//the deque rows reproduce the original std::deque<Vector2> + linear scan + rejection sampling design as a baseline
+//usage: microbench [--csv] [--max-size N] [--budget-ms N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "BatchRunner.h"
+
+static volatile long long sink; //keeps results observable so the timed loops are not optimised away
+
+struct Board {
+    int rows, cols;
+    std::vector<Cell> cycle; //hamiltonian cycle over every cell, the snake walks it so any length can move forever
+
+    Board(int rows, int cols) : rows(rows), cols(cols) {
+        //row 0 left to right, then serpentine over columns 1.. down the board, then back up column 0 (needs even rows)
+        for (int x = 0; x < cols; x++) cycle.push_back({int16_t(x), 0});
+        for (int y = 1; y < rows; y++) {
+            bool rightToLeft = y % 2 == 1;
+            for (int i = 1; i < cols; i++) cycle.push_back({int16_t(rightToLeft ? cols - i : i), int16_t(y)});
+        }
+        for (int y = rows - 1; y >= 1; y--) cycle.push_back({0, int16_t(y)});
+    }
+
+    int cells() const { return rows * cols; }
+    const Cell& at(long long i) const { return cycle[i % cycle.size()]; }
+};
+
+struct RingState { //the current design: ring buffer body plus occupancy grid with free list
+    SnakeBody body;
+    OccupancyGrid grid;
+    long long headIndex; //position of the head along the board cycle
+
+    RingState(const Board& board, int length) : body(board.cells()), grid(board.rows, board.cols), headIndex(length - 1) {
+        for (int i = length - 1; i >= 0; i--) { //head first
+            body.push_back(board.at(i));
+            grid.occupy(board.at(i));
+        }
+    }
+};
+
+struct DequeState { //the original design: deque body, every query scans it
+    std::deque<Cell> body;
+    long long headIndex;
+
+    DequeState(const Board& board, int length) : headIndex(length - 1) {
+        for (int i = length - 1; i >= 0; i--) body.push_back(board.at(i));
+    }
+
+    bool contains(const Cell& cell, int from) const {
+        for (size_t i = from; i < body.size(); i++) if (body[i] == cell) return true;
+        return false;
+    }
+};
+
+class Timer {
+    //repeats a case until the time budget is spent and reports the mean cost of one call
+
+private:
+    double budgetSeconds;
+
+public:
+    Timer(double budgetSeconds) : budgetSeconds(budgetSeconds) {}
+
+    template <typename Func>
+    double nsPerOp(Func func) {
+        using Clock = std::chrono::steady_clock;
+        long long iterations = 0;
+        long long batch = 1;
+        auto start = Clock::now();
+        double elapsed = 0;
+
+        while (elapsed < budgetSeconds) {
+            for (long long i = 0; i < batch; i++) func();
+            iterations += batch;
+            batch *= 2;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        return elapsed * 1e9 / iterations;
+    }
+};
+
+struct Reporter {
+    bool csv;
+
+    void header() const {
+        if (csv) printf("board,length,op,impl,ns_per_op\n");
+        else printf("%-10s %9s  %-16s %-12s %14s\n", "board", "length", "op", "impl", "ns/op");
+    }
+
+    void row(const Board& board, int length, const char* op, const char* impl, double ns) const {
+        if (csv) printf("%dx%d,%d,%s,%s,%.2f\n", board.rows, board.cols, length, op, impl, ns);
+        else if (ns < 0) printf("%4dx%-5d %9d  %-16s %-12s %14s\n", board.rows, board.cols, length, op, impl, "n/a");
+        else printf("%4dx%-5d %9d  %-16s %-12s %14.2f\n", board.rows, board.cols, length, op, impl, ns);
+    }
+};
+
+static void benchBoard(const Board& board, Timer& timer, const Reporter& report) {
+    int n = board.cells();
+    std::vector<int> lengths = {2, n / 4, n / 2, n * 3 / 4, n - 1, n};
+
+    for (int length : lengths) {
+        RingState ring(board, length);
+        DequeState deque(board, length);
+        Rng rng(length);
+
+        //move: tail out, head in, bookkeeping included
+        report.row(board, length, "move", "ring", timer.nsPerOp([&] {
+            Cell head = board.at(++ring.headIndex);
+            ring.grid.release(ring.body.back());
+            ring.body.pop_back();
+            ring.body.push_front(head);
+            ring.grid.occupy(head);
+        }));
+        report.row(board, length, "move", "deque", timer.nsPerOp([&] {
+            deque.body.pop_back();
+            deque.body.push_front(board.at(++deque.headIndex));
+        }));
+
+        //self-collision: is the head on any other segment
+        report.row(board, length, "self-collision", "grid", timer.nsPerOp([&] {
+            sink = sink + (ring.grid.count(ring.body.front()) > 1);
+        }));
+        report.row(board, length, "self-collision", "deque", timer.nsPerOp([&] {
+            sink = sink + deque.contains(deque.body.front(), 1);
+        }));
+
+        //border: is a candidate head off the board
+        long long probe = 0;
+        report.row(board, length, "border", "grid", timer.nsPerOp([&] {
+            Cell cell = board.at(probe++);
+            Cell shifted = {int16_t(cell.x + (probe & 1) * board.cols), cell.y}; //off the board every other call
+            sink = sink + ring.grid.inside(shifted);
+        }));
+
+        //spawn: pick a free cell for the apple
+        if (length < n) {
+            report.row(board, length, "spawn", "freelist", timer.nsPerOp([&] {
+                sink = sink + ring.grid.freeCellPos(rng.range(0, ring.grid.freeCount() - 1)).x;
+            }));
+            report.row(board, length, "spawn", "reject+grid", timer.nsPerOp([&] {
+                Cell pos;
+                do pos = {int16_t(rng.range(0, board.cols - 1)), int16_t(rng.range(0, board.rows - 1))};
+                while (ring.grid.occupied(pos));
+                sink = sink + pos.x;
+            }));
+            double expectedScan = double(length) * n / (n - length); //samples until a free cell times a full body scan each
+            if (expectedScan <= 1 << 24) { //beyond this one call takes long enough to stall the whole table
+                report.row(board, length, "spawn", "reject+deque", timer.nsPerOp([&] {
+                    Cell pos;
+                    do pos = {int16_t(rng.range(0, board.cols - 1)), int16_t(rng.range(0, board.rows - 1))};
+                    while (deque.contains(pos, 0));
+                    sink = sink + pos.x;
+                }));
+            }
+            else report.row(board, length, "spawn", "reject+deque", -1);
+        }
+        else { //full board: the free list reports it, rejection sampling would never return
+            report.row(board, length, "spawn", "freelist", timer.nsPerOp([&] { sink = sink + (ring.grid.freeCount() == 0); }));
+            report.row(board, length, "spawn", "reject+grid", -1);
+            report.row(board, length, "spawn", "reject+deque", -1);
+        }
+    }
+}
+
+static void benchStep(BoardSize size, bool generic, Timer& timer, const Reporter& report) {
+    //whole SnakeSim::step with the greedy policy, restarting games as they end
+    //generic forces the runtime-sized kernel so the compile-time specialised one can be compared against it
+    uint64_t seed = 1;
+    auto start = [&] {
+        SnakeSim sim(seed++, size);
+        if (generic) sim.useGenericKernel();
+        return sim;
+    };
+
+    SnakeSim sim = start();
+    Rng policyRng(2);
+    GreedyPolicy policy;
+
+    double ns = timer.nsPerOp([&] {
+        if (sim.step(policy(sim, policyRng))) sim = start();
+    });
+
+    bool specialised = sim.stepKernel() != SnakeSim::Kernel::Generic;
+    report.row(Board(size.rows, size.cols), 0, "SnakeSim::step", specialised ? "fixed" : "generic", ns);
+}
+
+static void benchSnapshot(BoardSize size, Timer& timer, const Reporter& report) {
+    //SimSnapshot save / restore against a deep SnakeSim copy, the rollback and search building blocks
+    static SimSnapshot<256 * 256> snapshot; //static, too big for the stack
+    SnakeSim sim(1, size);
+    Rng policyRng(2);
+    GreedyPolicy policy;
+    for (int tick = 0; tick < size.cells() && !sim.isOver(); tick++) sim.step(policy(sim, policyRng)); //some length to copy
+
+    Board board(size.rows, size.cols);
+    int length = sim.body().size();
+    sim.save(snapshot);
+
+    report.row(board, length, "snapshot", "save", timer.nsPerOp([&] { sink = sink + sim.save(snapshot); }));
+    report.row(board, length, "snapshot", "restore", timer.nsPerOp([&] { sink = sink + sim.restore(snapshot); }));
+    report.row(board, length, "snapshot", "sim copy", timer.nsPerOp([&] {
+        SnakeSim copy = sim;
+        sink = sink + copy.body().size();
+    }));
+}
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    int maxSize = 1024;
+    double budgetMs = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--csv")) csv = true;
+        else if (!strcmp(argv[i], "--max-size") && i + 1 < argc) maxSize = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--budget-ms") && i + 1 < argc) budgetMs = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: microbench [--csv] [--max-size N] [--budget-ms N]\n");
+            return 1;
+        }
+    }
+
+    Timer timer(budgetMs / 1e3);
+    Reporter report = {csv};
+    report.header();
+
+    for (int size = 16; size <= maxSize; size *= 4) benchBoard(Board(size, size), timer, report);
+
+    for (int size = 16; size <= std::min(maxSize, 256); size *= 2) {
+        benchStep({size, size}, false, timer, report);
+        benchStep({size, size}, true, timer, report);
+    }
+    benchStep({24, 24}, false, timer, report); //not a power of two, always the generic kernel
+
+    for (int size = 16; size <= std::min(maxSize, 256); size *= 4) benchSnapshot({size, size}, timer, report);
+
+    return 0;
+}
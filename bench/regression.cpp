@@ -0,0 +1,250 @@
+//release gate: fixed headless workloads timed the same way every run, results as JSON
+//single snake cases replay recorded Autopilot games (scripted input, identical ticks every run) on each board size,
+//arena cases run the greedy bots across snake counts; every case reports ticks/sec, ns/tick and heap allocations
+//per tick, single snake cases also time frames: one tick plus the per-segment interpolation Snake::Draw does
+//before handing quads to raylib (the GPU side cannot be timed headless)
+//each case keeps the fastest of a few runs; exits 1 if a steady-state tick allocates, 2 if a case's ticks/sec or frame p50/p99 is more than --tolerance worse than --baseline
+//usage: regression [--ticks N] [--out file.json] [--baseline file.json] [--tolerance F]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "Autopilot.h"
+#include "BatchRunner.h"
+#include "Replay.h"
+#include "RegressionReport.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" //free is the right match, operator new below is malloc
+#endif
+
+static std::atomic<long long> allocations = 0; //every operator new in the process, the bench reads deltas
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+static volatile long long sink; //keeps results observable so the timed loops are not optimised away
+
+using Clock = std::chrono::steady_clock;
+using Snapshot = SimSnapshot<256 * 256>; //the largest board the cases use
+
+static constexpr int repeats = 3; //each case is timed this many times and the fastest kept, a shared box is noisy
+
+template <typename Play>
+static void timeTicks(CaseResult& result, Play play) { //fastest of the repeats, allocations over all of them
+    long long before = allocations.load();
+    result.seconds = 1e300;
+
+    for (int run = 0; run < repeats; run++) {
+        auto begin = Clock::now();
+        for (long long i = 0; i < result.ticks; i++) play();
+        result.seconds = std::min(result.seconds, std::chrono::duration<double>(Clock::now() - begin).count());
+    }
+    result.allocations = (allocations.load() - before + repeats - 1) / repeats; //per run, any allocation at all rounds up to one
+}
+
+static std::vector<uint8_t> recordGame(uint64_t seed, BoardSize board, int maxTicks) { //an Autopilot game as replay bytes
+    SnakeSim sim(seed, board);
+    Autopilot pilot(Autopilot::Mode::Path);
+    ReplayWriter writer(seed, board);
+
+    for (int tick = 0; tick < maxTicks && !sim.isOver(); tick++) {
+        Direction input = pilot.next(sim);
+        sim.step(input);
+        writer.record(input, sim);
+    }
+    writer.finish(sim);
+    return writer.bytes();
+}
+
+struct Quad {
+    float x, y;
+};
+
+static void buildQuads(const SnakeSim& sim, float alpha, std::vector<Quad>& quads) { //Snake::Draw minus the draw calls
+    constexpr float cellSize = 50, offset = 50; //toPixel at the default board's scale
+    quads.clear(); //capacity reserved for the whole board
+
+    forEachSegmentPosition(sim, alpha, [&](const SegmentPosition& position) {
+        quads.push_back({offset + position.x * cellSize, offset + position.y * cellSize});
+    });
+}
+
+static CaseResult replayCase(BoardSize board, long long ticks, int frames) {
+    CaseResult result;
+    result.name = "replay " + std::to_string(board.rows) + "x" + std::to_string(board.cols);
+    result.board = board;
+    result.ticks = ticks;
+
+    uint64_t seed = 1000 + board.rows;
+    std::vector<uint8_t> bytes = recordGame(seed, board, 20000);
+    ReplayReader replay(bytes.data(), bytes.size());
+
+    SnakeSim sim(seed, board);
+    auto start = std::make_unique<Snapshot>();
+    sim.save(*start);
+
+    int tick = 0;
+    auto play = [&] { //next recorded input, back to the start of the game when the recording runs out
+        if (tick == replay.ticks() || sim.isOver()) {
+            sim.restore(*start);
+            tick = 0;
+        }
+        sim.step(replay.input(tick++));
+    };
+
+    for (int i = 0; i < 1000; i++) play(); //warm caches and the branch predictor
+
+    timeTicks(result, play);
+    result.snakeMoves = ticks;
+
+    std::vector<Quad> quads;
+    quads.reserve(board.cells());
+    std::vector<long long> frameTimes(frames);
+
+    for (int frame = 0; frame < frames; frame++) {
+        auto frameStart = Clock::now();
+        play();
+        buildQuads(sim, 0.5f, quads);
+        frameTimes[frame] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frameStart).count();
+        sink = sink + quads.size();
+    }
+
+    if (frames > 0) {
+        auto percentile = [&](double p) {
+            size_t at = std::min(frameTimes.size() - 1, size_t(p * frameTimes.size()));
+            std::nth_element(frameTimes.begin(), frameTimes.begin() + at, frameTimes.end());
+            return double(frameTimes[at]);
+        };
+        result.framed = true;
+        result.frameP50 = percentile(0.5);
+        result.frameP99 = percentile(0.99);
+        result.frameMax = percentile(1.0);
+    }
+
+    sink = sink + sim.scores().getScore();
+    return result;
+}
+
+static CaseResult arenaCase(BoardSize board, int snakes, long long ticks) {
+    CaseResult result;
+    result.name = "arena " + std::to_string(board.rows) + "x" + std::to_string(board.cols) + " " + std::to_string(snakes) + " snakes";
+    result.board = board;
+    result.snakes = snakes;
+    result.ticks = ticks;
+
+    ArenaConfig config;
+    config.board = board;
+    config.snakes = snakes;
+    config.apples = std::max(1, snakes / 2);
+
+    Arena arena(7, config);
+    GreedyPolicy policy;
+    std::vector<Rng> policyRngs;
+    for (int id = 0; id < snakes; id++) policyRngs.push_back(policyStream(7 * 1024 + id));
+
+    auto play = [&] {
+        for (int id = 0; id < arena.snakeCount(); id++) {
+            if (arena.snake(id).alive()) arena.setInput(id, policy(arena.view(id), policyRngs[id]));
+        }
+        result.snakeMoves += arena.alive();
+        arena.step();
+    };
+
+    for (int i = 0; i < 100; i++) play();
+    result.snakeMoves = 0;
+
+    timeTicks(result, play);
+    result.snakeMoves /= repeats;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    long long ticks = 2000000;
+    const char* outPath = nullptr;
+    const char* baselinePath = nullptr;
+    double tolerance = 0.15;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--ticks")) ticks = atoll(argv[i + 1]);
+        else if (!strcmp(argv[i], "--out")) outPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--baseline")) baselinePath = argv[i + 1];
+        else if (!strcmp(argv[i], "--tolerance")) tolerance = atof(argv[i + 1]);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (ticks < 1) {
+        fprintf(stderr, "ticks must be positive\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> baselineBytes;
+    if (baselinePath && !ReplayReader::loadFile(baselinePath, baselineBytes)) {
+        fprintf(stderr, "cannot read baseline %s\n", baselinePath);
+        return 1;
+    }
+    std::string baseline(baselineBytes.begin(), baselineBytes.end());
+
+    int frames = int(std::min<long long>(ticks / 10, 200000));
+    std::vector<CaseResult> results;
+    for (BoardSize board : {BoardSize{16, 16}, BoardSize{20, 20}, BoardSize{64, 64}, BoardSize{256, 256}}) { //20x20 runs the generic kernel
+        results.push_back(replayCase(board, ticks, frames));
+    }
+    results.push_back(arenaCase({64, 64}, 16, std::max(1LL, ticks / 100)));
+    results.push_back(arenaCase({256, 256}, 200, std::max(1LL, ticks / 1000)));
+
+    bool allocationFree = true;
+    for (const CaseResult& r : results) allocationFree &= r.allocations == 0;
+
+    std::string json = toJson(results, allocationFree);
+    fputs(json.c_str(), stdout);
+    if (outPath) {
+        FILE* out = fopen(outPath, "w");
+        if (!out) {
+            fprintf(stderr, "cannot write %s\n", outPath);
+            return 1;
+        }
+        fputs(json.c_str(), out);
+        fclose(out);
+    }
+
+    int status = allocationFree ? 0 : 1;
+    if (!allocationFree) fprintf(stderr, "FAIL: a steady-state tick allocated\n");
+
+    for (const CaseResult& r : results) {
+        if (!baselinePath) break;
+
+        double before = baselineValue(baseline, r, "ticks_per_sec");
+        if (before > 0 && r.ticksPerSecond() < before * (1 - tolerance)) {
+            fprintf(stderr, "FAIL: %s at %.0f ticks/sec, baseline %.0f\n", r.name.c_str(), r.ticksPerSecond(), before);
+            status = 2;
+        }
+        if (!r.framed) continue;
+
+        struct {const char* key; double now;} frames[] = {{"frame_p50_ns", r.frameP50}, {"frame_p99_ns", r.frameP99}};
+        for (auto& frame : frames) { //the max is one outlier on a shared box, too noisy to gate on
+            double was = baselineValue(baseline, r, frame.key);
+            if (was > 0 && frame.now > was * (1 + tolerance)) {
+                fprintf(stderr, "FAIL: %s %s %.0f, baseline %.0f\n", r.name.c_str(), frame.key, frame.now, was);
+                status = 2;
+            }
+        }
+    }
+    return status;
+}
@@ -0,0 +1,151 @@
+//the C ABI in snake_env.h: the environments are SoABatch games, one batch per chunk stepped in lockstep on a ThreadPool
+//a finished game is reset in place, so after create no step ever touches the heap
+//exceptions stop here, the caller may be C or Python
+
+#include "snake_env.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "SoABatch.h"
+#include "ThreadPool.h"
+
+struct SnakeEnv {
+    struct Chunk {
+        SoABatch batch;
+        int first; //environment index of game 0
+        std::vector<int32_t> before; //score ahead of the tick in progress, for the reward
+    };
+
+    BoardSize board;
+    uint64_t seed;
+    int maxTicks;
+    int count;
+    std::vector<Chunk> chunks;
+    std::vector<long long> episodes; //started so far per environment, create starts episode 0
+    std::vector<int32_t> scores; //of the episode that last stepped, kept through the reset that follows it
+    std::unique_ptr<ThreadPool> pool; //null for one thread, stepping inline beats handing off
+
+    static constexpr int minGrain = 16; //games per batch, at least one AVX2 register of lanes
+
+    SnakeEnv(int count, BoardSize board, uint64_t seed, int maxTicks, unsigned threads) :
+        board(board), seed(seed), maxTicks(maxTicks), count(count), episodes(count, 1), scores(count, 0)
+    {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads > 1) pool = std::make_unique<ThreadPool>(threads);
+
+        int grain = pool ? std::max(minGrain, count / (pool->size() * 4)) : count; //a few chunks per worker so stealing evens out
+        chunks.reserve((count + grain - 1) / grain);
+        for (int first = 0; first < count; first += grain) {
+            int games = std::min(grain, count - first);
+            chunks.push_back({SoABatch(games, seed + first, board), first, std::vector<int32_t>(games, 0)});
+        }
+    }
+
+    uint64_t episodeSeed(int i) const { return seed + uint64_t(episodes[i]) * count + i; }
+
+    void restart(Chunk& chunk, int game) { //reuses the game's body and grid
+        int i = chunk.first + game;
+        chunk.batch.reset(game, episodeSeed(i));
+        episodes[i]++;
+    }
+
+    void observe(const Chunk& chunk, int game, uint8_t* out) const { //the occupancy counts are 0 or 1, games that end are reset first
+        SoABatch::GameView view = chunk.batch.view(game);
+        DynamicShape shape = {board.rows, board.cols};
+
+        memcpy(out, view.grid().counts(), board.cells());
+        if (view.hasApple()) out[shape.index(view.apple())] = SNAKE_ENV_APPLE;
+
+        Cell head = view.body().front();
+        if (shape.inside(head)) out[shape.index(head)] = SNAKE_ENV_HEAD;
+    }
+
+    template <typename Func>
+    void forEach(Func func) { //func(chunk) for every chunk, over the pool
+        if (!pool) {
+            for (Chunk& chunk : chunks) func(chunk);
+            return;
+        }
+        pool->parallelFor(0, chunks.size(), 1, [&](int first, int last) {
+            for (int c = first; c < last; c++) func(chunks[c]);
+        });
+    }
+};
+
+extern "C" {
+
+SnakeEnv* snake_env_create(int count, int rows, int cols, uint64_t seed, int max_ticks, int threads) {
+    BoardSize board = {rows, cols};
+    if (count < 1 || !board.valid() || max_ticks < 0 || threads < 0) return nullptr;
+
+    try {
+        return new SnakeEnv(count, board, seed, max_ticks, threads);
+    }
+    catch (...) { //bad_alloc for a huge count or board, system_error if threads cannot start
+        return nullptr;
+    }
+}
+
+void snake_env_destroy(SnakeEnv* env) { delete env; }
+
+int snake_env_count(const SnakeEnv* env) { return env->count; }
+int snake_env_rows(const SnakeEnv* env) { return env->board.rows; }
+int snake_env_cols(const SnakeEnv* env) { return env->board.cols; }
+
+void snake_env_reset(SnakeEnv* env, uint8_t* observations) {
+    size_t cells = env->board.cells();
+    env->forEach([&](SnakeEnv::Chunk& chunk) {
+        for (int game = 0; game < chunk.batch.size(); game++) {
+            int i = chunk.first + game;
+            env->episodes[i] = 0;
+            env->restart(chunk, game);
+            env->scores[i] = 0;
+            if (observations) env->observe(chunk, game, observations + i * cells);
+        }
+    });
+}
+
+void snake_env_step(SnakeEnv* env, const uint8_t* actions, uint8_t* observations, float* rewards, uint8_t* dones) {
+    size_t cells = env->board.cells();
+    env->forEach([&](SnakeEnv::Chunk& chunk) {
+        SoABatch& batch = chunk.batch;
+
+        for (int game = 0; game < batch.size(); game++) { //every game is live, the finished ones were reset last step
+            int i = chunk.first + game;
+            SoABatch::GameView view = batch.view(game);
+            batch.setInput(game, actions && actions[i] < 4 ? Direction(actions[i]) : view.heading());
+            chunk.before[game] = view.score();
+        }
+
+        batch.step();
+
+        for (int game = 0; game < batch.size(); game++) {
+            int i = chunk.first + game;
+            SoABatch::GameView view = batch.view(game);
+
+            float reward = view.score() != chunk.before[game] ? 1.0f : 0.0f;
+            uint8_t done = SNAKE_ENV_RUNNING;
+            if (view.isOver()) {
+                done = view.isWon() ? SNAKE_ENV_WON : SNAKE_ENV_DIED;
+                if (done == SNAKE_ENV_DIED) reward -= 1.0f;
+            }
+            else if (env->maxTicks > 0 && view.ticks() >= env->maxTicks) done = SNAKE_ENV_TRUNCATED;
+
+            env->scores[i] = view.score();
+            if (done != SNAKE_ENV_RUNNING) env->restart(chunk, game);
+
+            if (observations) env->observe(chunk, game, observations + i * cells);
+            if (rewards) rewards[i] = reward;
+            if (dones) dones[i] = done;
+        }
+    });
+}
+
+void snake_env_scores(const SnakeEnv* env, int32_t* scores) {
+    std::copy(env->scores.begin(), env->scores.end(), scores);
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef SNAKE_ENV_H
+#define SNAKE_ENV_H
+
+/*
+ * C ABI over the headless core for training agents: N games stepped together, every result written straight
+ * into buffers the caller owns, so a step costs one call however many environments there are
+ * build with make env (bin/libsnakeenv.so, bin/snakeenv.dll on Windows); bindings/snake_env.py wraps it for Python
+ *
+ * observations are rows * cols bytes per environment, row major, environments back to back:
+ *   SNAKE_ENV_EMPTY, SNAKE_ENV_BODY, SNAKE_ENV_HEAD or SNAKE_ENV_APPLE
+ * copied from the occupancy grid the collision checks read, then the head and apple written over it
+ * actions are one byte per environment, 0 up, 1 down, 2 left, 3 right; a reversal or anything else keeps the heading
+ * an environment that finishes reports its reward and done code on that step and is already reset in the
+ * observation, so the caller never has to reset one by hand
+ */
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#define SNAKE_ENV_API __declspec(dllexport)
+#else
+#define SNAKE_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    SNAKE_ENV_EMPTY = 0,
+    SNAKE_ENV_BODY = 1,
+    SNAKE_ENV_HEAD = 2,
+    SNAKE_ENV_APPLE = 3
+};
+
+enum { /* done codes */
+    SNAKE_ENV_RUNNING = 0,
+    SNAKE_ENV_DIED = 1,
+    SNAKE_ENV_WON = 2, /* filled the board */
+    SNAKE_ENV_TRUNCATED = 3 /* hit max_ticks alive */
+};
+
+typedef struct SnakeEnv SnakeEnv;
+
+/* NULL on bad arguments or out of memory; threads 0 uses every core, max_ticks 0 never truncates
+   the kth episode of environment i, counting from 0 at create, is seeded seed + k * count + i,
+   so a run is reproducible whatever the thread count */
+SNAKE_ENV_API SnakeEnv* snake_env_create(int count, int rows, int cols, uint64_t seed, int max_ticks, int threads);
+SNAKE_ENV_API void snake_env_destroy(SnakeEnv* env);
+
+SNAKE_ENV_API int snake_env_count(const SnakeEnv* env);
+SNAKE_ENV_API int snake_env_rows(const SnakeEnv* env);
+SNAKE_ENV_API int snake_env_cols(const SnakeEnv* env);
+
+/* starts every environment over from episode 0, the same games create began; observations may be NULL */
+SNAKE_ENV_API void snake_env_reset(SnakeEnv* env, uint8_t* observations);
+
+/* one tick of every environment; rewards are +1 per apple, -1 on death; any output may be NULL */
+SNAKE_ENV_API void snake_env_step(SnakeEnv* env, const uint8_t* actions, uint8_t* observations, float* rewards, uint8_t* dones);
+
+/* per environment score of the running episode, or of the one that just ended on the step that reported it */
+SNAKE_ENV_API void snake_env_scores(const SnakeEnv* env, int32_t* scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+"""Vectorized Snake environments over the C ABI in snake_env.h.
+
+Build the library first with `make env`. The step writes observations, rewards and done codes straight into numpy
+arrays this wrapper allocates once, so a step is one foreign call for all environments and no copies. The arrays
+returned by reset() and step() are those same buffers: copy them to keep a step around past the next call.
+
+    env = VecSnakeEnv(1024, rows=16, cols=16, seed=1)
+    obs = env.reset()                        # (1024, 16, 16) uint8
+    obs, rewards, dones = env.step(actions)  # actions: (1024,) uint8, 0 up, 1 down, 2 left, 3 right
+"""
+
+import ctypes
+import os
+import sys
+
+import numpy as np
+
+EMPTY, BODY, HEAD, APPLE = 0, 1, 2, 3
+RUNNING, DIED, WON, TRUNCATED = 0, 1, 2, 3
+
+_u8p = ctypes.POINTER(ctypes.c_uint8)
+
+
+def _default_library():
+    name = "snakeenv.dll" if sys.platform == "win32" else "libsnakeenv.so"
+    return os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "bin", name)
+
+
+def _load(path):
+    lib = ctypes.CDLL(path)
+    lib.snake_env_create.restype = ctypes.c_void_p
+    lib.snake_env_create.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_uint64, ctypes.c_int, ctypes.c_int]
+    lib.snake_env_destroy.argtypes = [ctypes.c_void_p]
+    lib.snake_env_reset.argtypes = [ctypes.c_void_p, _u8p]
+    lib.snake_env_step.argtypes = [ctypes.c_void_p, _u8p, _u8p, ctypes.POINTER(ctypes.c_float), _u8p]
+    lib.snake_env_scores.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int32)]
+    return lib
+
+
+class VecSnakeEnv:
+    def __init__(self, num_envs, rows=16, cols=16, seed=1, max_ticks=0, threads=0, library=None):
+        self._lib = _load(library or os.environ.get("SNAKE_ENV_LIB") or _default_library())
+        self._env = self._lib.snake_env_create(num_envs, rows, cols, seed, max_ticks, threads)
+        if not self._env:
+            raise ValueError("cannot create %d environments of %dx%d" % (num_envs, rows, cols))
+
+        self.num_envs, self.rows, self.cols = num_envs, rows, cols
+        self.observations = np.zeros((num_envs, rows, cols), dtype=np.uint8)
+        self.rewards = np.zeros(num_envs, dtype=np.float32)
+        self.dones = np.zeros(num_envs, dtype=np.uint8)
+        self._scores = np.zeros(num_envs, dtype=np.int32)
+
+        # pointers taken once, the buffers never move
+        self._obs_ptr = self.observations.ctypes.data_as(_u8p)
+        self._reward_ptr = self.rewards.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+        self._done_ptr = self.dones.ctypes.data_as(_u8p)
+
+    def reset(self):
+        self._lib.snake_env_reset(self._env, self._obs_ptr)
+        return self.observations
+
+    def step(self, actions):
+        actions = np.ascontiguousarray(actions, dtype=np.uint8)  # no copy when the caller already passes uint8
+        if actions.shape != (self.num_envs,):
+            raise ValueError("expected %d actions, got shape %s" % (self.num_envs, actions.shape))
+
+        self._lib.snake_env_step(self._env, actions.ctypes.data_as(_u8p), self._obs_ptr, self._reward_ptr, self._done_ptr)
+        return self.observations, self.rewards, self.dones
+
+    def scores(self):
+        self._lib.snake_env_scores(self._env, self._scores.ctypes.data_as(ctypes.POINTER(ctypes.c_int32)))
+        return self._scores
+
+    def close(self):
+        if self._env:
+            self._lib.snake_env_destroy(self._env)
+            self._env = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        if getattr(self, "_env", None):
+            self.close()
@@ -0,0 +1,304 @@
+#pragma once
+
+//many snakes on one board, all moving at once every tick
+//one OccupancyGrid shared by every body answers head-vs-any-body in O(1), and a per-cell stamp of the tick a head
+//last claimed it catches head-vs-head, so a tick costs O(snakes) no matter how long the bodies are
+//a dying snake releases its body once, which is O(its length) but only on the tick it dies
+//plain C++ like SnakeSim; state and randomness are per arena so arenas run side by side on a ThreadPool
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "SnakeSim.h"
+
+struct ArenaConfig {
+    BoardSize board = {64, 64};
+    int snakes = 16;
+    int apples = 16; //kept on the board at all times while there is room
+    int maxLength = 1024; //ring capacity per snake, past it eating still scores but no longer grows
+    int respawnDelay = 10; //ticks a dead snake waits before re-entering, negative to stay dead
+};
+
+class ArenaSnake {
+    friend class Arena;
+    friend class ArenaCollision;
+
+private:
+    SnakeBody snakeBody;
+    Direction direction = Direction::Left;
+    Direction input = Direction::Left;
+    Cell nextHead = {0, 0}; //scratch for the tick in progress
+
+    bool isAlive = false;
+    bool addSegment = false;
+    bool dying = false;
+
+    int score = 0;
+    int length = 0;
+    int deaths = 0;
+    long long respawnTick = 0;
+
+public:
+    ArenaSnake(int capacity) : snakeBody(capacity) {}
+
+    const SnakeBody& body() const { return snakeBody; }
+    Direction heading() const { return direction; }
+    bool alive() const { return isAlive; }
+    bool growing() const { return addSegment && snakeBody.size() < snakeBody.capacity(); } //a full ring drops the segment
+    int getScore() const { return score; }
+    int getLength() const { return length; }
+    int getDeaths() const { return deaths; }
+};
+
+class ArenaCollision {
+    //the multi-snake CollisionHandler: border, head-vs-body and head-vs-head for every snake in one pass
+    friend class Arena;
+
+private:
+    std::vector<uint32_t> claimTick; //tick + 1 a head last entered the cell, so a zeroed grid means unclaimed
+    std::vector<int> claimer; //which snake made that claim
+
+    ArenaCollision(int cells) : claimTick(cells, 0), claimer(cells, -1) {}
+
+    template <typename Shape>
+    void resolve(std::vector<ArenaSnake>& snakes, const OccupancyGrid& grid, const Shape& shape, uint32_t stamp) {
+        //tails have already left, heads not yet entered: a head cell still occupied means it hit a body
+        for (int id = 0; id < int(snakes.size()); id++) {
+            ArenaSnake& snake = snakes[id];
+            if (!snake.isAlive) continue;
+
+            Cell head = snake.nextHead;
+            if (!shape.inside(head)) {
+                snake.dying = true;
+                continue;
+            }
+
+            int cell = shape.index(head);
+            if (grid.countIndex(cell) > 0) snake.dying = true;
+
+            if (claimTick[cell] == stamp) { //another head got here this tick, both die
+                snake.dying = true;
+                snakes[claimer[cell]].dying = true;
+            }
+            else {
+                claimTick[cell] = stamp;
+                claimer[cell] = id;
+            }
+        }
+    }
+};
+
+class Arena {
+private:
+    ArenaConfig config;
+    DynamicShape shape;
+    Rng rng;
+
+    OccupancyGrid occupancy; //every live body on the board
+    ArenaCollision collision;
+
+    std::vector<ArenaSnake> snakes;
+    std::vector<uint8_t> appleAt; //per cell
+    std::vector<Cell> appleCells;
+
+    long long tickCount = 0;
+    int liveSnakes = 0;
+
+    static constexpr int spawnAttempts = 64;
+
+    bool spawnApple() { //random free cell that does not already hold an apple
+        if (occupancy.freeCount() == 0) return false;
+
+        for (int attempt = 0; attempt < spawnAttempts; attempt++) {
+            int cell = occupancy.freeCellIndex(rng.range(0, occupancy.freeCount() - 1));
+            if (appleAt[cell]) continue;
+
+            appleAt[cell] = 1;
+            appleCells.push_back(shape.cellAt(cell));
+            return true;
+        }
+        return false; //apples far outnumber free cells, try again next tick
+    }
+
+    void eatApple(const Cell& cell) {
+        appleAt[shape.index(cell)] = 0;
+        for (size_t i = 0; i < appleCells.size(); i++) {
+            if (appleCells[i] == cell) { //apples are few, a linear swap-remove beats keeping a second index
+                appleCells[i] = appleCells.back();
+                appleCells.pop_back();
+                break;
+            }
+        }
+    }
+
+    bool enterable(const Cell& cell) const { //a body may enter it: on the board, no body and no apple, which would hide under it
+        return shape.inside(cell) && !occupancy.occupied(cell) && !appleAt[shape.index(cell)];
+    }
+
+    void enter(ArenaSnake& snake, const Cell* body, int count, Direction heading) { //cells already checked free
+        snake.snakeBody.assign(body, count); //reuses the ring, respawning never allocates
+        for (int i = 0; i < count; i++) occupancy.occupy(body[i]);
+
+        snake.direction = snake.input = heading;
+        snake.isAlive = true;
+        snake.dying = false;
+        snake.addSegment = false;
+        snake.length = count;
+        liveSnakes++;
+    }
+
+    bool spawnSnake(ArenaSnake& snake) { //two free cells side by side, heading left like the single player start
+        for (int attempt = 0; attempt < spawnAttempts && occupancy.freeCount() > 0; attempt++) {
+            Cell head = shape.cellAt(occupancy.freeCellIndex(rng.range(0, occupancy.freeCount() - 1)));
+            Cell tail = head + toStep(Direction::Right);
+            Cell ahead = head + toStep(Direction::Left);
+            if (!enterable(head) || !enterable(tail) || !shape.inside(ahead) || occupancy.occupied(ahead)) continue; //an apple ahead is fine, it gets eaten
+
+            Cell start[2] = {head, tail};
+            enter(snake, start, 2, Direction::Left);
+            return true;
+        }
+        return false;
+    }
+
+    void kill(ArenaSnake& snake) {
+        snake.snakeBody.forEach([&](const Cell& segment) { occupancy.release(segment); });
+        snake.isAlive = false;
+        snake.dying = false;
+        snake.deaths++;
+        snake.respawnTick = config.respawnDelay < 0 ? -1 : tickCount + config.respawnDelay;
+        liveSnakes--;
+    }
+
+public:
+    Arena(uint64_t seed, ArenaConfig config) :
+        config(config), shape{config.board.rows, config.board.cols}, rng(seed),
+        occupancy(config.board.rows, config.board.cols), collision(config.board.cells()),
+        appleAt(config.board.cells(), 0)
+    {
+        snakes.reserve(config.snakes);
+        for (int id = 0; id < config.snakes; id++) {
+            snakes.emplace_back(std::min(config.maxLength, config.board.cells()));
+            spawnSnake(snakes.back());
+        }
+
+        appleCells.reserve(config.apples);
+        for (int i = 0; i < config.apples; i++) spawnApple();
+    }
+
+    void setInput(int snake, Direction direction) { snakes[snake].input = direction; }
+
+    bool place(int id, const Cell* body, int count, Direction heading) { //head first; scripted scenarios, false if any cell is taken
+        ArenaSnake& snake = snakes[id];
+        if (snake.isAlive) kill(snake); //counts as a death, respawns as configured if placing fails
+
+        if (count < 1 || count > snake.snakeBody.capacity()) return false;
+        for (int i = 0; i < count; i++) {
+            if (!enterable(body[i])) return false;
+            for (int j = 0; j < i; j++) if (body[j] == body[i]) return false;
+        }
+        enter(snake, body, count, heading);
+        return true;
+    }
+
+    void remove(int id) { //scripted scenarios: takes a snake off the board, it respawns as configured
+        if (snakes[id].isAlive) kill(snakes[id]);
+    }
+
+    void clearApples() { //scripted scenarios; the spawn tops the board back up on every tick while config.apples > 0
+        for (const Cell& cell : appleCells) appleAt[shape.index(cell)] = 0;
+        appleCells.clear();
+    }
+
+    void step() { //one tick for every snake
+        tickCount++;
+        uint32_t stamp = uint32_t(tickCount); //wraps after four billion ticks, a stale match then is one spurious head-on
+
+        //move: pick headings and let tails leave first, same order as SnakeSim so a head may follow a tail
+        for (ArenaSnake& snake : snakes) {
+            if (!snake.isAlive) continue;
+
+            if (!isOpposite(snake.input, snake.direction)) snake.direction = snake.input; //reversing into the neck is ignored
+            snake.nextHead = snake.snakeBody.front() + toStep(snake.direction);
+
+            if (snake.addSegment && snake.snakeBody.size() < snake.snakeBody.capacity()) snake.addSegment = false;
+            else {
+                snake.addSegment = false;
+                occupancy.release(snake.snakeBody.back());
+                snake.snakeBody.pop_back();
+            }
+        }
+
+        collision.resolve(snakes, occupancy, shape, stamp);
+
+        for (ArenaSnake& snake : snakes) {
+            if (!snake.isAlive) continue;
+            if (snake.dying) {
+                kill(snake);
+                continue;
+            }
+
+            snake.snakeBody.push_front(snake.nextHead);
+            occupancy.occupy(snake.nextHead);
+
+            if (appleAt[shape.index(snake.nextHead)]) {
+                eatApple(snake.nextHead);
+                snake.addSegment = true;
+                snake.score += 10;
+                if (snake.length < snake.snakeBody.capacity()) snake.length++; //growth stops at capacity, so does the length
+            }
+        }
+
+        for (ArenaSnake& snake : snakes) { //after every head has landed, so nobody spawns into a cell just entered
+            if (!snake.isAlive && snake.respawnTick >= 0 && tickCount > snake.respawnTick) spawnSnake(snake);
+        }
+
+        while (int(appleCells.size()) < config.apples && spawnApple()) {}
+    }
+
+    const ArenaConfig& settings() const { return config; }
+    long long ticks() const { return tickCount; }
+    int alive() const { return liveSnakes; }
+
+    int snakeCount() const { return snakes.size(); }
+    const ArenaSnake& snake(int id) const { return snakes[id]; }
+
+    const OccupancyGrid& grid() const { return occupancy; }
+    const std::vector<Cell>& apples() const { return appleCells; }
+    bool hasAppleAt(const Cell& cell) const { return shape.inside(cell) && appleAt[shape.index(cell)]; }
+
+    class SnakeView {
+        //one snake seen through the SnakeSim interface the batch policies read, with its nearest apple as the target
+        friend class Arena;
+
+    private:
+        const Arena* arena;
+        int id;
+        Cell target = {0, 0};
+
+        SnakeView(const Arena* arena, int id) : arena(arena), id(id) {
+            Cell head = body().front();
+            int bestDistance = INT32_MAX;
+
+            for (const Cell& cell : arena->appleCells) { //O(apples) once per view, a handful per arena
+                int distance = std::abs(cell.x - head.x) + std::abs(cell.y - head.y);
+                if (distance < bestDistance) {
+                    target = cell;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+    public:
+        const SnakeBody& body() const { return arena->snakes[id].body(); }
+        const OccupancyGrid& grid() const { return arena->occupancy; }
+        Direction heading() const { return arena->snakes[id].heading(); }
+        bool growing() const { return arena->snakes[id].growing(); }
+        bool hasApple() const { return !arena->appleCells.empty(); }
+        Cell apple() const { return target; }
+    };
+
+    SnakeView view(int id) const { return SnakeView(this, id); } //only for a live snake, a dead one has no head
+};
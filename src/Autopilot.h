@@ -0,0 +1,242 @@
+#pragma once
+
+//native autopilot: picks each tick's direction from the sim, for AI benchmarks and as a stand-in for the keyboard
+//Path mode walks a BFS shortest path to the apple over the occupancy grid, refusing moves whose flood fill is too small
+//to hold the snake; Cycle mode follows a Hamiltonian cycle, which cannot fail, and uses the same BFS to cut corners
+//toward the apple whenever the cut cannot strand the snake, so it finishes every board that has a cycle, and
+//falls back to Path on boards that have none (both sides odd)
+//every buffer is sized once per board, planning a tick never allocates
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SnakeSim.h"
+
+class Autopilot {
+public:
+    enum class Mode : uint8_t {Path, Cycle};
+
+private:
+    Mode mode;
+    BoardSize board = {0, 0};
+    DynamicShape shape = {0, 0};
+    bool cycleExists = false;
+    bool reversed = false; //walk the cycle backwards this game, chosen at the start so the first step is not a reversal
+
+    std::vector<int> cycleIndex; //cell -> position along the cycle
+    std::vector<int> queue; //BFS frontier, one slot per cell, reused every search
+    std::vector<int> dist;
+    std::vector<uint32_t> visited; //search generation that last reached the cell, so nothing is cleared between searches
+    uint32_t generation = 0;
+
+    void prepare(BoardSize size) { //once per board size
+        if (size.rows == board.rows && size.cols == board.cols) return;
+        board = size;
+        shape = {size.rows, size.cols};
+
+        int cells = size.cells();
+        cycleIndex.assign(cells, 0);
+        queue.assign(cells, 0);
+        dist.assign(cells, 0);
+        visited.assign(cells, 0);
+        generation = 0;
+
+        //serpentine: along the first row, snake back and forth over the other columns, then home up the first column
+        //needs an even number of rows, transposed when only the columns are even
+        bool transpose = size.rows % 2 != 0;
+        int rows = transpose ? size.cols : size.rows;
+        int cols = transpose ? size.rows : size.cols;
+        cycleExists = rows % 2 == 0 && cols >= 2;
+        if (!cycleExists) return;
+
+        int position = 0;
+        auto visit = [&](int x, int y) {
+            Cell cell = transpose ? Cell{int16_t(y), int16_t(x)} : Cell{int16_t(x), int16_t(y)};
+            cycleIndex[shape.index(cell)] = position++;
+        };
+
+        for (int x = 0; x < cols; x++) visit(x, 0);
+        for (int y = 1; y < rows; y++) {
+            for (int i = 1; i < cols; i++) visit(y % 2 == 1 ? cols - i : i, y);
+        }
+        for (int y = rows - 1; y >= 1; y--) visit(0, y);
+    }
+
+    int cycleDistance(const Cell& from, const Cell& to) const { //steps forward along the cycle
+        int cells = board.cells();
+        int d = cycleIndex[shape.index(to)] - cycleIndex[shape.index(from)];
+        if (reversed) d = -d;
+        return d < 0 ? d + cells : d;
+    }
+
+    bool passable(const SnakeSim& sim, const Cell& cell, bool tailMoves) const { //free now, or the tail that leaves this tick
+        if (!shape.inside(cell)) return false;
+        unsigned int count = sim.grid().count(cell);
+        return count == 0 || (count == 1 && tailMoves && cell == sim.body().back());
+    }
+
+    int distanceField(const SnakeSim& sim, bool tailMoves) { //BFS outward from the apple until it reaches the head, -1 if it never does
+        generation++;
+        Cell head = sim.body().front();
+        int target = shape.index(head);
+        int start = shape.index(sim.apple());
+
+        int first = 0, last = 0;
+        queue[last++] = start;
+        visited[start] = generation;
+        dist[start] = 0;
+
+        while (first < last) {
+            int cell = queue[first++];
+            Cell pos = shape.cellAt(cell);
+
+            for (int d = 0; d < 4; d++) {
+                Cell next = pos + toStep(Direction(d));
+                if (!shape.inside(next)) continue;
+
+                int index = shape.index(next);
+                if (visited[index] == generation) continue;
+
+                if (index == target) { //every neighbour on a shortest path is labelled by now
+                    visited[index] = generation;
+                    dist[index] = dist[cell] + 1;
+                    return dist[index];
+                }
+                if (!passable(sim, next, tailMoves)) continue;
+
+                visited[index] = generation;
+                dist[index] = dist[cell] + 1;
+                queue[last++] = index;
+            }
+        }
+        return -1;
+    }
+
+    int distanceTo(const Cell& cell) const { //from the last distanceField, INT32_MAX when it was never reached
+        if (!shape.inside(cell)) return INT32_MAX;
+        int index = shape.index(cell);
+        return visited[index] == generation ? dist[index] : INT32_MAX;
+    }
+
+    int floodArea(const SnakeSim& sim, const Cell& from, bool tailMoves, int enough) { //cells reachable after stepping onto from
+        generation++;
+        int first = 0, last = 0;
+        int start = shape.index(from);
+        queue[last++] = start;
+        visited[start] = generation;
+        visited[shape.index(sim.body().front())] = generation; //the old head becomes body
+
+        while (first < last && last < enough) {
+            Cell pos = shape.cellAt(queue[first++]);
+            for (int d = 0; d < 4; d++) {
+                Cell next = pos + toStep(Direction(d));
+                if (!passable(sim, next, tailMoves)) continue;
+
+                int index = shape.index(next);
+                if (visited[index] == generation) continue;
+                visited[index] = generation;
+                queue[last++] = index;
+            }
+        }
+        return last;
+    }
+
+    Direction planPath(const SnakeSim& sim, bool tailMoves) {
+        //shortest path to the apple unless that move leaves too little room, else the roomiest move
+        Cell head = sim.body().front();
+        bool reachable = sim.hasApple() && distanceField(sim, tailMoves) >= 0;
+
+        int distances[4];
+        for (int d = 0; d < 4; d++) distances[d] = reachable ? distanceTo(head + toStep(Direction(d))) : INT32_MAX;
+
+        Direction best = sim.heading();
+        int bestDistance = INT32_MAX, bestArea = -1;
+        int length = sim.body().size();
+
+        for (int d = 0; d < 4; d++) {
+            Direction candidate = Direction(d);
+            Cell next = head + toStep(candidate);
+            if (isOpposite(candidate, sim.heading()) || !passable(sim, next, tailMoves)) continue;
+
+            int area = floodArea(sim, next, tailMoves, length + 1);
+            bool roomy = area > length;
+            int distance = roomy ? distances[d] : INT32_MAX;
+
+            if (distance < bestDistance || (distance == bestDistance && area > bestArea)) {
+                best = candidate;
+                bestDistance = distance;
+                bestArea = area;
+            }
+        }
+        return best;
+    }
+
+    Direction planCycle(const SnakeSim& sim, bool tailMoves, int growth) {
+        //cut ahead along the cycle only as far as stays behind the tail with room for growth, and never past the apple
+        //same budget rule as the classic Hamiltonian shortcut bot; the BFS picks which allowed cut gets closest
+        Cell head = sim.body().front();
+        int cells = board.cells();
+        int length = sim.body().size();
+
+        int toTail = cycleDistance(head, sim.body().back());
+        int toApple = sim.hasApple() ? cycleDistance(head, sim.apple()) : cells;
+        int empty = cells - length - growth - 1;
+
+        int budget = toTail - growth - 3;
+        if (empty < cells / 2) budget = 0; //crowded board, the cycle alone is safe
+        else if (toApple < toTail) {
+            budget -= 1; //eating on the way grows us once more
+            if ((toTail - toApple) * 4 > empty) budget -= 10; //and the next apple may land right in front
+        }
+        budget = std::max(0, std::min(budget, toApple));
+
+        bool reachable = budget > 0 && sim.hasApple() && distanceField(sim, tailMoves) >= 0;
+
+        Direction best = sim.heading();
+        int bestAhead = -1, bestDistance = INT32_MAX;
+
+        for (int d = 0; d < 4; d++) {
+            Direction candidate = Direction(d);
+            Cell next = head + toStep(candidate);
+            if (isOpposite(candidate, sim.heading()) || !passable(sim, next, tailMoves)) continue;
+
+            int ahead = cycleDistance(head, next);
+            if (ahead != 1 && ahead > budget) continue; //the next cycle cell is always allowed
+
+            int distance = reachable ? distanceTo(next) : INT32_MAX;
+            if (distance < bestDistance || (distance == bestDistance && ahead > bestAhead)) {
+                best = candidate;
+                bestAhead = ahead;
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+
+public:
+    Autopilot(Mode mode = Mode::Cycle) : mode(mode) {}
+
+    static Mode parse(const std::string& name) { return name == "path" ? Mode::Path : Mode::Cycle; }
+
+    bool cycles() const { return mode == Mode::Cycle && cycleExists; } //Cycle mode on a board with no cycle plans paths
+
+    Direction next(const SnakeSim& sim) {
+        prepare(sim.boardSize());
+
+        int growth = sim.scores().getLength() - sim.body().size(); //eaten but not grown yet, the tail stays next tick
+        bool tailMoves = growth == 0;
+
+        if (mode == Mode::Cycle && cycleExists) {
+            if (!sim.started()) { //two cells, so any orientation keeps the body in cycle order; avoid reversing at once
+                reversed = false;
+                Cell head = sim.body().front();
+                reversed = cycleDistance(head, sim.body().back()) == 1;
+            }
+            return planCycle(sim, tailMoves, growth);
+        }
+        return planPath(sim, tailMoves);
+    }
+
+    Direction operator()(const SnakeSim& sim, Rng&) { return next(sim); } //BatchRunner policy signature
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+//runs many independent headless games across every core and folds their results into one set of stats
+//each game gets its own seed so a batch is reproducible regardless of thread count or scheduling
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "SnakeSim.h"
+#include "SoABatch.h"
+#include "ThreadPool.h"
+
+//policies only read heading(), body(), growing(), grid(), hasApple() and apple(), so they drive SnakeSim and SoABatch games alike
+
+struct RandomPolicy {
+    //uniform over the three directions that are not a reversal, mostly useful as a throughput baseline
+    template <typename Game>
+    Direction operator()(const Game& sim, Rng& rng) const {
+        Direction choice;
+        do choice = Direction(rng.range(0, 3));
+        while (isOpposite(choice, sim.heading()));
+        return choice;
+    }
+};
+
+struct GreedyPolicy {
+    //steps toward the apple, refusing moves that die on the spot
+    template <typename Game>
+    Direction operator()(const Game& sim, Rng& rng) const {
+        Cell head = sim.body().front();
+        Direction best = sim.heading();
+        int bestDistance = INT32_MAX;
+        int ties = 0;
+
+        for (int d = 0; d < 4; d++) {
+            Direction candidate = Direction(d);
+            if (isOpposite(candidate, sim.heading())) continue;
+
+            Cell next = head + toStep(candidate);
+            bool tailMoves = next == sim.body().back() && !sim.growing(); //tail cell frees up this tick unless it waits for a segment
+            if (!sim.grid().inside(next) || (sim.grid().occupied(next) && !tailMoves)) continue;
+
+            int distance = sim.hasApple() ? std::abs(next.x - sim.apple().x) + std::abs(next.y - sim.apple().y) : 0;
+
+            if (distance < bestDistance) {
+                best = candidate;
+                bestDistance = distance;
+                ties = 1;
+            }
+            else if (distance == bestDistance && rng.range(0, ties++) == 0) best = candidate; //reservoir pick keeps ties unbiased
+        }
+
+        return best;
+    }
+};
+
+struct BatchConfig {
+    BoardSize board = defaultBoard;
+    int games = 1000;
+    uint64_t seed = 1; //game i is seeded with seed + i
+    int maxTicks = 100000; //per game, stops policies that circle forever without dying
+    int grain = 16; //games per task, small enough that stealing can even out long and short games
+};
+
+struct BatchStats {
+    long long games = 0;
+    long long ticks = 0;
+    long long totalScore = 0;
+    long long totalLength = 0;
+    int maxScore = 0;
+    int maxLength = 0;
+    long long wins = 0; //board filled
+    long long timeouts = 0; //hit maxTicks still alive
+
+    void add(int score, int length, bool won, bool over, int gameTicks) {
+        games++;
+        ticks += gameTicks;
+        totalScore += score;
+        totalLength += length;
+        maxScore = std::max(maxScore, score);
+        maxLength = std::max(maxLength, length);
+        if (won) wins++;
+        else if (!over) timeouts++;
+    }
+
+    void add(const SnakeSim& sim, int gameTicks) {
+        add(sim.scores().getScore(), sim.scores().getLength(), sim.collisions().isBoardFull(), sim.isOver(), gameTicks);
+    }
+
+    void merge(const BatchStats& other) {
+        games += other.games;
+        ticks += other.ticks;
+        totalScore += other.totalScore;
+        totalLength += other.totalLength;
+        maxScore = std::max(maxScore, other.maxScore);
+        maxLength = std::max(maxLength, other.maxLength);
+        wins += other.wins;
+        timeouts += other.timeouts;
+    }
+
+    double meanScore() const { return games ? double(totalScore) / games : 0; }
+    double meanLength() const { return games ? double(totalLength) / games : 0; }
+};
+
+inline Rng policyStream(uint64_t gameSeed) { //separate stream so the policy never shifts apple spawns
+    return Rng(gameSeed ^ 0x9e3779b97f4a7c15ull);
+}
+
+template <typename Policy>
+int playGame(SnakeSim& sim, Policy& policy, Rng& policyRng, int maxTicks) { //returns ticks played
+    int ticks = 0;
+    while (ticks < maxTicks) {
+        ticks++;
+        if (sim.step(policy(sim, policyRng))) break;
+    }
+    return ticks;
+}
+
+template <typename Policy>
+BatchStats runBatch(ThreadPool& pool, const BatchConfig& config, Policy policy = Policy()) {
+    //policy(const SnakeSim&, Rng&) -> Direction, copied into every task so it needs no locking
+    int chunks = (config.games + config.grain - 1) / config.grain;
+    std::vector<BatchStats> chunkStats(chunks); //one slot per task, merged after the join instead of contending on a lock
+
+    pool.parallelFor(0, config.games, config.grain, [&](int first, int last) {
+        BatchStats& local = chunkStats[first / config.grain];
+        Policy taskPolicy = policy;
+        SnakeSim sim(config.seed + first, config.board); //one per task, reset between games so only the first allocates
+
+        for (int game = first; game < last; game++) {
+            if (game > first) sim.reset(config.seed + game);
+            Rng policyRng = policyStream(config.seed + game);
+
+            local.add(sim, playGame(sim, taskPolicy, policyRng, config.maxTicks));
+        }
+    });
+
+    BatchStats total;
+    for (const BatchStats& stats : chunkStats) total.merge(stats);
+    return total;
+}
+
+template <typename Policy>
+BatchStats runSoABatch(ThreadPool& pool, const BatchConfig& config, Policy policy = Policy()) {
+    //same games and seeds as runBatch, but each task steps a whole SoABatch of grain games in lockstep
+    int chunks = (config.games + config.grain - 1) / config.grain;
+    std::vector<BatchStats> chunkStats(chunks);
+
+    pool.parallelFor(0, config.games, config.grain, [&](int first, int last) {
+        Policy taskPolicy = policy;
+        SoABatch batch(last - first, config.seed + first, config.board);
+
+        std::vector<Rng> policyRngs;
+        for (int game = first; game < last; game++) policyRngs.push_back(policyStream(config.seed + game));
+
+        for (int tick = 0; tick < config.maxTicks && batch.running() > 0; tick++) {
+            for (int game = 0; game < batch.size(); game++) {
+                SoABatch::GameView view = batch.view(game);
+                if (!view.isOver()) batch.setInput(game, taskPolicy(view, policyRngs[game]));
+            }
+            batch.step();
+        }
+
+        BatchStats& local = chunkStats[first / config.grain];
+        for (int game = 0; game < batch.size(); game++) {
+            SoABatch::GameView view = batch.view(game);
+            local.add(view.score(), view.length(), view.isWon(), view.isOver(), view.ticks());
+        }
+    });
+
+    BatchStats total;
+    for (const BatchStats& stats : chunkStats) total.merge(stats);
+    return total;
+}
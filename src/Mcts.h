@@ -0,0 +1,252 @@
+#pragma once
+
+//parallel Monte Carlo tree search over SnakeSim, a slower but tunable alternative to the Autopilot
+//every worker restores the root from one SimSnapshot, walks the shared tree by UCT, rolls out with the greedy policy
+//and backs the reward up; tree statistics are atomics updated without locks, and a rollout in flight adds virtual
+//visits to its path so the other workers spread over different branches instead of piling onto the same one
+//the tree is open loop: nodes are move sequences and each rollout reseeds the sim, so apple spawns are chance,
+//never foresight of where the real game's next apple lands
+//nodes come from one pool sized up front, a decision never allocates
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BatchRunner.h"
+#include "SnakeSim.h"
+#include "ThreadPool.h"
+
+struct MctsConfig {
+    int iterations = 2048; //rollouts per decision, shared out over the workers
+    int horizon = 64; //ticks past the root an iteration looks ahead, tree walk and rollout together
+    int maxNodes = 1 << 18; //tree capacity, once full the leaves stop expanding and only roll out
+    double exploration = 0.7; //UCT constant, rewards are in apples
+    int virtualLoss = 2; //extra visits an unfinished rollout holds on its path
+    double discount = 0.97; //per tick, an apple now is worth more than the same apple later
+    double survivalBonus = 2.0; //for reaching the horizon (or filling the board) alive
+};
+
+struct MctsStats {
+    long long decisions = 0;
+    long long rollouts = 0;
+    long long ticks = 0; //simulated, tree walk plus rollouts
+    long long nodes = 0; //expanded, summed over decisions
+    double seconds = 0; //inside search
+
+    double rolloutsPerSecond() const { return seconds > 0 ? rollouts / seconds : 0; }
+    double ticksPerSecond() const { return seconds > 0 ? ticks / seconds : 0; }
+};
+
+struct MctsNode {
+    static constexpr int32_t noChild = -1;
+
+    std::atomic<int32_t> child[4]; //by Direction
+    std::atomic<int32_t> visits; //finished rollouts through here plus the virtual ones in flight
+    std::atomic<int64_t> value; //reward sum, fixed point
+
+    void reset() {
+        for (auto& slot : child) slot.store(noChild, std::memory_order_relaxed);
+        visits.store(0, std::memory_order_relaxed);
+        value.store(0, std::memory_order_relaxed);
+    }
+};
+
+class MctsAgent {
+public:
+    static constexpr int maxCells = 256 * 256; //the largest board with a step kernel; bigger boards play greedy
+    using Snapshot = SimSnapshot<maxCells>;
+
+private:
+    static constexpr double valueScale = 1 << 20;
+
+    struct Worker {
+        SnakeSim sim;
+        Rng rng;
+        std::vector<int32_t> path; //nodes visited this iteration, root first
+        long long ticks = 0;
+
+        Worker(BoardSize board, uint64_t seed, int horizon) : sim(0, board), rng(policyStream(seed)) {
+            path.reserve(horizon + 1);
+        }
+    };
+
+    MctsConfig config;
+    ThreadPool& pool;
+    BoardSize board = {0, 0};
+
+    std::unique_ptr<Snapshot> root = std::make_unique<Snapshot>();
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::unique_ptr<MctsNode[]> nodes;
+    std::atomic<int32_t> nodeCount = 0;
+    std::atomic<int> nextIteration = 0;
+    uint64_t rolloutSeed = 0; //advances by iterations every decision, so no two rollouts share an apple stream
+
+    MctsStats totals;
+    GreedyPolicy rolloutPolicy;
+
+    void prepare(BoardSize size) { //once per board size
+        if (size == board) return;
+        board = size;
+
+        workers.clear();
+        for (int i = 0; i < pool.size(); i++) workers.push_back(std::make_unique<Worker>(size, i, config.horizon));
+    }
+
+    int32_t allocate() { //a fresh node or noChild when the pool is spent
+        int32_t index = nodeCount.fetch_add(1, std::memory_order_relaxed);
+        if (index >= config.maxNodes) return MctsNode::noChild;
+
+        nodes[index].reset();
+        return index;
+    }
+
+    void enter(Worker& worker, int32_t node) {
+        nodes[node].visits.fetch_add(1 + config.virtualLoss, std::memory_order_relaxed);
+        worker.path.push_back(node);
+    }
+
+    Direction select(Worker& worker, int32_t node, Direction heading) const {
+        //an untried move first, picked from a random start so workers do not all expand in the same order, else UCT
+        const MctsNode& parent = nodes[node];
+        int start = worker.rng.range(0, 3);
+
+        for (int i = 0; i < 4; i++) {
+            Direction candidate = Direction((start + i) % 4);
+            if (!isOpposite(candidate, heading) && parent.child[int(candidate)].load(std::memory_order_acquire) == MctsNode::noChild) return candidate;
+        }
+
+        double logParent = std::log(double(std::max(1, parent.visits.load(std::memory_order_relaxed))));
+        Direction best = heading;
+        double bestScore = -1e300;
+
+        for (int d = 0; d < 4; d++) {
+            if (isOpposite(Direction(d), heading)) continue;
+
+            const MctsNode& child = nodes[parent.child[d].load(std::memory_order_acquire)];
+            int visits = std::max(1, child.visits.load(std::memory_order_relaxed)); //virtual visits count, their value does not yet
+            double mean = child.value.load(std::memory_order_relaxed) / valueScale / visits;
+            double score = mean + config.exploration * std::sqrt(logParent / visits);
+
+            if (score > bestScore) {
+                best = Direction(d);
+                bestScore = score;
+            }
+        }
+        return best;
+    }
+
+    void iterate(Worker& worker, int iteration) {
+        SnakeSim& sim = worker.sim;
+        sim.restore(*root);
+        sim.reseed(rolloutSeed + iteration);
+
+        worker.path.clear();
+        enter(worker, 0);
+
+        double reward = 0, weight = 1;
+        int tick = 0;
+
+        auto advance = [&](Direction input) {
+            int score = sim.scores().getScore();
+            sim.step(input);
+            if (sim.scores().getScore() != score) reward += weight;
+            weight *= config.discount;
+            tick++;
+        };
+
+        int32_t node = 0;
+        bool expanded = false;
+        while (tick < config.horizon && !sim.isOver() && !expanded) { //walk the tree until a new leaf or a full pool
+            Direction input = select(worker, node, sim.heading());
+            std::atomic<int32_t>& slot = nodes[node].child[int(input)];
+            int32_t next = slot.load(std::memory_order_acquire);
+
+            if (next == MctsNode::noChild) {
+                int32_t fresh = allocate();
+                if (fresh == MctsNode::noChild) { //no room, roll out from here
+                    advance(input);
+                    break;
+                }
+                if (slot.compare_exchange_strong(next, fresh, std::memory_order_release, std::memory_order_acquire)) {
+                    next = fresh;
+                    expanded = true;
+                }
+                //else another worker expanded it first, next now holds theirs and this node is left unused
+            }
+
+            advance(input);
+            node = next;
+            enter(worker, node);
+        }
+
+        while (tick < config.horizon && !sim.isOver()) advance(rolloutPolicy(sim, worker.rng));
+
+        if (!sim.isOver() || sim.collisions().isBoardFull()) reward += config.survivalBonus * weight;
+        worker.ticks += tick;
+
+        int64_t fixed = int64_t(reward * valueScale);
+        for (int32_t visited : worker.path) {
+            nodes[visited].value.fetch_add(fixed, std::memory_order_relaxed);
+            nodes[visited].visits.fetch_sub(config.virtualLoss, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    MctsAgent(ThreadPool& pool, MctsConfig config = {}) : config(config), pool(pool), nodes(new MctsNode[config.maxNodes]) {}
+
+    MctsAgent(const MctsAgent&) = delete;
+    MctsAgent& operator=(const MctsAgent&) = delete;
+
+    Direction next(const SnakeSim& sim) { //fans the search out over the pool, so never call it from inside a pool task
+        if (!sim.save(*root)) {
+            Rng unused;
+            return rolloutPolicy(sim, unused);
+        }
+        prepare(sim.boardSize());
+
+        auto start = std::chrono::steady_clock::now();
+        nodes[0].reset();
+        nodeCount = 1;
+        nextIteration = 0;
+
+        pool.parallelFor(0, workers.size(), 1, [&](int first, int) {
+            Worker& worker = *workers[first];
+            int iteration;
+            while ((iteration = nextIteration.fetch_add(1, std::memory_order_relaxed)) < config.iterations) iterate(worker, iteration);
+        });
+        rolloutSeed += config.iterations;
+
+        Direction best = sim.heading(); //most visited root move, steadier than the best mean
+        int bestVisits = -1;
+        for (int d = 0; d < 4; d++) {
+            int32_t child = nodes[0].child[d].load(std::memory_order_relaxed);
+            if (child == MctsNode::noChild || isOpposite(Direction(d), sim.heading())) continue;
+
+            int visits = nodes[child].visits.load(std::memory_order_relaxed);
+            if (visits > bestVisits) {
+                best = Direction(d);
+                bestVisits = visits;
+            }
+        }
+
+        totals.decisions++;
+        totals.rollouts += config.iterations;
+        totals.nodes += std::min<int32_t>(nodeCount.load(), config.maxNodes);
+        totals.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (auto& worker : workers) {
+            totals.ticks += worker->ticks;
+            worker->ticks = 0;
+        }
+        return best;
+    }
+
+    Direction operator()(const SnakeSim& sim, Rng&) { return next(sim); } //BatchRunner policy signature
+
+    const MctsConfig& settings() const { return config; }
+    const MctsStats& stats() const { return totals; }
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+//client end of NetProtocol: joins a match, streams inputs with redundancy and follows the server's deltas
+//call send() at least once per tick and poll() every frame, neither blocks
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "NetProtocol.h"
+#include "NetSocket.h"
+
+class NetClient {
+public:
+    struct Applied { //a tick poll() just took from the server
+        uint32_t tick;
+        NetProtocol::TickDelta delta;
+    };
+
+private:
+    UdpSocket socket;
+    NetAddress server;
+    BoardSize board = defaultBoard;
+
+    uint32_t session = 0;
+    uint64_t matchSeed = 0;
+    int serverTps = 0;
+    std::unique_ptr<NetMirror> mirror; //made on welcome, once the board is confirmed
+
+    Direction inputs[NetProtocol::historyTicks] = {};
+    uint32_t firstInput = NetProtocol::noTick;
+    uint32_t newestInput = NetProtocol::noTick;
+
+    std::vector<Applied> applied;
+    bool resync = false;
+    bool needFull = false; //a delta did not fit our state, acks go out empty until a full state replaces it
+
+    std::vector<uint8_t> packet;
+    uint8_t buffer[NetProtocol::maxFullState];
+
+    double lossRate = 0; //share of datagrams dropped on purpose both ways, to exercise the redundancy
+    uint32_t lossState = 1;
+
+    long long sentBytes = 0;
+    long long receivedBytes = 0;
+
+    bool dropped() {
+        if (lossRate <= 0) return false;
+        lossState = lossState * 1664525u + 1013904223u;
+        return (lossState >> 8) * (1.0 / (1 << 24)) < lossRate;
+    }
+
+    void transmit() {
+        sentBytes += packet.size();
+        if (!dropped()) socket.send(server, packet.data(), packet.size());
+    }
+
+    void handle(const uint8_t* data, size_t size) {
+        ByteReader reader(data, size);
+        uint8_t type = reader.u8();
+        uint32_t from = reader.u32();
+        if (reader.failed()) return;
+
+        if (type == NetProtocol::Welcome && !mirror) {
+            BoardSize offered = {reader.u16(), reader.u16()};
+            matchSeed = reader.u64();
+            serverTps = reader.u16();
+            if (reader.failed() || !(offered.rows == board.rows && offered.cols == board.cols)) return;
+
+            session = from;
+            mirror = std::make_unique<NetMirror>(board);
+            mirror->start(matchSeed);
+            return;
+        }
+        if (!mirror || from != session) return; //stale datagrams from an earlier match
+
+        if (type == NetProtocol::Deltas) {
+            uint32_t tick = reader.u32();
+            int count = reader.u8();
+            NetProtocol::TickDelta delta;
+
+            for (int i = 0; i < count && delta.read(reader); i++, tick++) {
+                if (tick <= mirror->lastTick()) continue; //already have it, redundancy at work
+                if (!mirror->apply(tick, delta)) { //a gap, the next packet starts from our ack again
+                    if (tick == mirror->lastTick() + 1) needFull = true; //the next tick, yet it does not fit: start over from a full state
+                    break;
+                }
+                applied.push_back({tick, delta});
+            }
+        }
+        else if (type == NetProtocol::Full) {
+            uint32_t tick = reader.u32();
+            if (reader.failed() || tick <= mirror->lastTick()) return;
+
+            if (mirror->applyFull(tick, reader.cursor(), data + size - reader.cursor())) {
+                applied.clear(); //deltas before the full state no longer chain onto anything
+                resync = true;
+                needFull = false;
+            }
+        }
+    }
+
+public:
+    bool connect(const char* hostPort, BoardSize requested) {
+        board = requested;
+        if (!NetProtocol::servable(board) || !NetAddress::parse(hostPort, server)) return false;
+        if (!socket.open()) return false;
+
+        session = 0;
+        mirror.reset();
+        needFull = false;
+        firstInput = newestInput = NetProtocol::noTick;
+        return true;
+    }
+
+    void disconnect() {
+        if (!socket.good()) return;
+        if (mirror) {
+            packet.clear();
+            ByteWriter writer(packet);
+            NetProtocol::header(writer, NetProtocol::Bye, session);
+            transmit();
+        }
+        socket.close();
+        mirror.reset();
+    }
+
+    ~NetClient() { disconnect(); }
+
+    bool joined() const { return mirror != nullptr; }
+    uint64_t seed() const { return matchSeed; }
+    int ticksPerSecond() const { return serverTps; }
+    BoardSize boardSize() const { return board; }
+    const NetMirror& state() const { return *mirror; } //only once joined()
+
+    void setLoss(double rate) { lossRate = rate; }
+    long long bytesSent() const { return sentBytes; }
+    long long bytesReceived() const { return receivedBytes; }
+
+    void setInput(uint32_t tick, Direction input) { //ticks only move forward, skipped ones repeat the last input
+        if (newestInput != NetProtocol::noTick && tick <= newestInput) {
+            if (newestInput - tick < NetProtocol::historyTicks) inputs[tick % NetProtocol::historyTicks] = input;
+            return;
+        }
+
+        if (newestInput == NetProtocol::noTick) firstInput = tick;
+        else for (uint32_t t = newestInput + 1; t < tick; t++) inputs[t % NetProtocol::historyTicks] = inputs[newestInput % NetProtocol::historyTicks];
+
+        inputs[tick % NetProtocol::historyTicks] = input;
+        newestInput = tick;
+    }
+
+    void send() { //hello until welcomed, then the ack plus the newest inputs
+        if (!socket.good()) return;
+        packet.clear();
+        ByteWriter writer(packet);
+
+        if (!mirror) {
+            NetProtocol::header(writer, NetProtocol::Hello, 0);
+            writer.u16(board.rows);
+            writer.u16(board.cols);
+            transmit();
+            return;
+        }
+
+        NetProtocol::header(writer, NetProtocol::Input, session);
+        writer.u32(needFull ? NetProtocol::noTick : mirror->lastTick()); //no ack asks the server for a full state
+
+        int count = 0;
+        uint32_t first = 0;
+        if (newestInput != NetProtocol::noTick) {
+            count = std::min<uint32_t>(NetProtocol::inputRedundancy, newestInput - firstInput + 1);
+            first = newestInput + 1 - count;
+        }
+
+        Direction window[NetProtocol::inputRedundancy];
+        for (int i = 0; i < count; i++) window[i] = inputs[(first + i) % NetProtocol::historyTicks];
+
+        writer.u32(first);
+        writer.u8(count);
+        NetProtocol::packInputs(writer, window, count);
+        transmit();
+    }
+
+    const std::vector<Applied>& poll() { //drains the socket; the ticks applied since the last poll, oldest first
+        applied.clear();
+        resync = false;
+        if (!socket.good()) return applied;
+
+        NetAddress from;
+        int size;
+        while ((size = socket.receive(from, buffer, sizeof(buffer))) > 0) {
+            if (!(from == server)) continue;
+            receivedBytes += size;
+            if (!dropped()) handle(buffer, size);
+        }
+        return applied;
+    }
+
+    const std::vector<Applied>& lastPoll() const { return applied; } //what the last poll() returned
+
+    bool resynced() const { return resync; } //poll() took a full state, resyncedState() holds it
+    const SnakeSim& resyncedState() const { return mirror->lastFull(); } //decoded once, by the mirror, only after resynced()
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+//client-side prediction with rollback on top of NetClient: local input is stepped at once instead of after a round trip,
+//the server's applied inputs confirm those ticks later, and a tick the server played differently (our input arrived late)
+//is re-simulated from the last confirmed state with the local inputs since, all deterministic so nothing else can differ
+//the ring holds SimSnapshots, so a tick costs one save and a rollback one restore plus the re-simulated steps
+//plain C++, the front-end drives it with --connect and tools could drive it headless
+
+#include <vector>
+
+#include "NetClient.h"
+
+class PredictedGame {
+public:
+    using Snapshot = SimSnapshot<NetProtocol::maxCells>;
+
+private:
+    static constexpr int ring = NetProtocol::historyTicks; //state after tick t lives at t % ring
+
+    NetClient& client;
+    SnakeSim current; //at predictedTick
+    std::vector<Snapshot> states; //valid from confirmedTick to predictedTick, allocated once, saved into in place
+    Direction localInput[ring] = {};
+
+    uint32_t confirmedTick = 0; //every tick up to here matches the server
+    uint32_t predictedTick = 0;
+
+    double lastSend = -1;
+    bool heard = false; //ticks arrived since the last send, the server wants them acked
+    int rollbackCount = 0;
+    int correctedTicks = 0; //re-simulated because of rollbacks
+
+    Snapshot& at(uint32_t tick) { return states[tick % ring]; }
+
+    void stepAndSave(uint32_t tick, Direction input) { //current is at tick - 1
+        current.step(input);
+        current.save(at(tick));
+        localInput[tick % ring] = input;
+    }
+
+    void replayFrom(uint32_t tick) { //current is at tick, re-derive tick + 1 .. predictedTick with the local inputs
+        for (uint32_t t = tick + 1; t <= predictedTick; t++) {
+            stepAndSave(t, localInput[t % ring]);
+            correctedTicks++;
+        }
+    }
+
+    bool confirm(const NetClient::Applied& applied) { //true when the shown state had to change
+        uint32_t tick = applied.tick;
+        Direction truth = applied.delta.applied();
+
+        if (tick > predictedTick) { //the server got ahead of us, just follow
+            stepAndSave(tick, truth);
+            predictedTick = confirmedTick = tick;
+            return true;
+        }
+
+        confirmedTick = tick;
+        const Snapshot& guess = at(tick);
+        if (Direction(guess.direction) == truth && guess.body[0] == applied.delta.head) return false;
+
+        current.restore(at(tick - 1)); //the previous tick was confirmed, so this is exactly the server's state
+        stepAndSave(tick, truth);
+        replayFrom(tick);
+        rollbackCount++;
+        return true;
+    }
+
+public:
+    static constexpr int maxPrediction = 48; //ticks ahead of the server before prediction waits, keeps the ring valid
+    static constexpr int leadTicks = 1; //extra ticks the local clock starts ahead, so inputs reach the server in time
+    static constexpr double keepAlive = 0.1; //seconds between sends when nothing else prompts one
+
+    PredictedGame(NetClient& client) : client(client), current(client.seed(), client.boardSize()), states(ring) {
+        current.save(at(0));
+    }
+
+    const SnakeSim& predicted() const { return current; }
+    const Snapshot& confirmed() const { return states[confirmedTick % ring]; }
+    uint32_t tick() const { return predictedTick; }
+    uint32_t ahead() const { return predictedTick - confirmedTick; }
+    bool canPredict() const { return ahead() < maxPrediction; }
+
+    int rollbacks() const { return rollbackCount; }
+    int resimulated() const { return correctedTicks; }
+
+    void advance(Direction input) { //one local tick, sent to the server on the next flush
+        uint32_t tick = predictedTick + 1;
+        stepAndSave(tick, input);
+        predictedTick = tick;
+        client.setInput(tick, input);
+    }
+
+    bool reconcile() { //once a frame before ticking: take the server's ticks, true when predicted() was corrected
+        const std::vector<NetClient::Applied>& applied = client.poll();
+        bool corrected = false;
+
+        if (client.resynced()) { //too far behind for deltas, start again from the server's full state
+            uint32_t tick = client.state().lastTick();
+            client.resyncedState().save(at(tick)); //NetClient already decoded and checked it, this is a copy
+            current.restore(at(tick));
+
+            confirmedTick = tick;
+            if (predictedTick <= tick) predictedTick = tick;
+            else replayFrom(tick);
+            corrected = true;
+        }
+
+        for (const NetClient::Applied& tick : applied) corrected |= confirm(tick);
+        heard |= !applied.empty();
+        return corrected;
+    }
+
+    void flush(double now, bool advanced) { //once a frame after ticking: ack what arrived and carry the newest inputs
+        if (!advanced && !heard && now - lastSend < keepAlive) return;
+        client.send();
+        lastSend = now;
+        heard = false;
+    }
+};
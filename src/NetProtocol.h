@@ -0,0 +1,203 @@
+#pragma once
+
+//wire format for online play: the server owns the SnakeSim and streams what changed each tick, never whole bodies
+//a TickDelta is 5 bytes at least whatever the snake's length (new head, whether the tail moved, apple and score
+//only when they change); with the 10 byte deltas header and unacked deltas resent until the ack arrives, net bots
+//measures about 17 bytes down per client tick; both directions repeat their recent history so one lost datagram costs nothing
+//plain C++ on top of Replay.h's byte helpers, shared by tools/net.cpp and NetClient.h
+//
+//one message per datagram, all integers little endian, every message starts u8 type u32 session
+//client -> server
+//  'H' hello    u16 rows u16 cols                      (session 0) asks for a new match on that board
+//  'I' input    u32 ack u32 firstTick u8 count, then count inputs 2 bits each, lowest bits first
+//               ack is the last tick the client holds, noTick before its first state
+//               the last inputRedundancy inputs ride along every time, late duplicates are dropped by tick
+//  'B' bye
+//server -> client
+//  'W' welcome  u16 rows u16 cols u64 seed u16 ticksPerSecond, tick 0 is SnakeSim(seed, board) so no state is sent
+//  'D' deltas   u32 firstTick u8 count, then count TickDelta oldest first, each relative to the tick before it
+//  'F' full     u32 tick, then StateCodec state, when the client is missing more than the server still keeps
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "Replay.h"
+
+namespace NetProtocol {
+    constexpr uint16_t defaultPort = 27960;
+    constexpr uint32_t noTick = 0xffffffffu;
+
+    constexpr int maxDatagram = 1200; //under any path MTU, every message but a full state stays below it
+    constexpr int maxFullState = 65000; //a full state may fragment, it is rare, but it must fit one UDP datagram
+    constexpr int inputRedundancy = 8;
+    constexpr int deltasPerPacket = 16; //oldest unacked first, covers a round trip of up to 16 ticks
+    constexpr int historyTicks = 64; //deltas and inputs kept per match, a power of two so tick % historyTicks is a mask
+
+    constexpr int maxCells = 64 * 64; //largest board served, clients keep historyTicks snapshots of this size
+
+    inline bool servable(BoardSize board) { //a full state (4 bytes a cell at worst) then always fits one datagram
+        static_assert(4 * maxCells + 64 <= maxFullState);
+        return board.valid() && board.cells() <= maxCells;
+    }
+
+    enum Type : uint8_t {Hello = 'H', Input = 'I', Bye = 'B', Welcome = 'W', Deltas = 'D', Full = 'F'};
+
+    struct TickDelta {
+        enum Flag : uint8_t {TailMoved = 4, AppleMoved = 8, ScoreChanged = 16, Over = 32, Won = 64}; //low 2 bits: direction applied
+
+        uint8_t flags = 0;
+        Cell head = {0, 0};
+        Cell apple = {0, 0};
+        int32_t score = 0;
+
+        Direction applied() const { return Direction(flags & 3); }
+
+        struct Before { //the fields a tick can change, captured before SnakeSim::step instead of copying the sim
+            int length;
+            Cell apple;
+            bool hasApple;
+            int32_t score;
+        };
+
+        static Before capture(const SnakeSim& sim) {
+            return {sim.body().size(), sim.apple(), sim.hasApple(), sim.scores().getScore()};
+        }
+
+        static TickDelta between(const Before& before, const SnakeSim& after) {
+            TickDelta delta;
+            delta.flags = uint8_t(after.heading());
+            delta.head = after.body().front();
+            delta.apple = after.apple();
+            delta.score = after.scores().getScore();
+
+            if (after.body().size() == before.length) delta.flags |= TailMoved;
+            if (after.hasApple() && (!before.hasApple || !(after.apple() == before.apple))) delta.flags |= AppleMoved;
+            if (delta.score != before.score) delta.flags |= ScoreChanged;
+            if (after.isOver()) delta.flags |= Over;
+            if (after.collisions().isBoardFull()) delta.flags |= Won;
+            return delta;
+        }
+
+        void write(ByteWriter& writer) const {
+            writer.u8(flags);
+            writer.u16(head.x);
+            writer.u16(head.y);
+            if (flags & AppleMoved) {
+                writer.u16(apple.x);
+                writer.u16(apple.y);
+            }
+            if (flags & ScoreChanged) writer.u32(score);
+        }
+
+        bool read(ByteReader& reader) {
+            flags = reader.u8();
+            head = {int16_t(reader.u16()), int16_t(reader.u16())};
+            if (flags & AppleMoved) apple = {int16_t(reader.u16()), int16_t(reader.u16())};
+            if (flags & ScoreChanged) score = reader.u32();
+            return !reader.failed();
+        }
+    };
+
+    inline void header(ByteWriter& writer, Type type, uint32_t session) {
+        writer.u8(type);
+        writer.u32(session);
+    }
+
+    inline void packInputs(ByteWriter& writer, const Direction* inputs, int count) {
+        for (int i = 0; i < count; i += 4) {
+            uint8_t packed = 0;
+            for (int j = 0; j < 4 && i + j < count; j++) packed |= uint8_t(inputs[i + j]) << (2 * j);
+            writer.u8(packed);
+        }
+    }
+
+    inline bool unpackInputs(ByteReader& reader, Direction* inputs, int count) {
+        for (int i = 0; i < count; i += 4) {
+            uint8_t packed = reader.u8();
+            for (int j = 0; j < 4 && i + j < count; j++) inputs[i + j] = Direction((packed >> (2 * j)) & 3);
+        }
+        return !reader.failed();
+    }
+}
+
+class NetMirror {
+    //what a thin client knows: the body, apple and score rebuilt from deltas, enough to draw the game
+    //no RNG and no free list, so it can follow but never predict; NetClient adds prediction on top
+
+private:
+    SnakeSim scratch; //only to build tick 0 and decode full states, StateCodec reads into a sim
+    SnakeBody snakeBody;
+    Cell applePos = {0, 0};
+    bool appleSpawned = false;
+    int32_t score = 0;
+    uint32_t tick = NetProtocol::noTick;
+    uint8_t lastFlags = 0;
+
+    void adopt(const SnakeSim& sim, uint32_t simTick) {
+        snakeBody = SnakeBody(snakeBody.capacity());
+        sim.body().forEach([&](const Cell& segment) { snakeBody.push_back(segment); });
+        applePos = sim.apple();
+        appleSpawned = sim.hasApple();
+        score = sim.scores().getScore();
+        lastFlags = uint8_t(sim.heading()) | (sim.isOver() ? NetProtocol::TickDelta::Over : 0)
+            | (sim.collisions().isBoardFull() ? NetProtocol::TickDelta::Won : 0);
+        tick = simTick;
+    }
+
+public:
+    NetMirror(BoardSize board) : scratch(0, board), snakeBody(board.cells()) {}
+
+    bool ready() const { return tick != NetProtocol::noTick; }
+    uint32_t lastTick() const { return tick; }
+
+    const SnakeBody& body() const { return snakeBody; }
+    bool hasApple() const { return appleSpawned; }
+    Cell apple() const { return applePos; }
+    int getScore() const { return score; }
+    bool isOver() const { return lastFlags & NetProtocol::TickDelta::Over; }
+    bool won() const { return lastFlags & NetProtocol::TickDelta::Won; }
+
+    void start(uint64_t seed) { //tick 0, straight from the seed the welcome carried
+        scratch = SnakeSim(seed, scratch.boardSize());
+        adopt(scratch, 0);
+    }
+
+    const SnakeSim& lastFull() const { return scratch; } //what the last successful applyFull decoded, RNG and free list included
+
+    bool applyFull(uint32_t fullTick, const uint8_t* data, size_t size) { //StateCodec::read changes scratch only on success
+        if (!StateCodec::read(scratch, data, size)) return false;
+        adopt(scratch, fullTick);
+        return true;
+    }
+
+    bool consistent(const NetProtocol::TickDelta& delta) const { //could this delta follow the state we hold
+        DynamicShape shape = {scratch.boardSize().rows, scratch.boardSize().cols};
+        Cell from = snakeBody.front();
+        bool over = delta.flags & NetProtocol::TickDelta::Over;
+
+        if (isOver()) return false; //the server stops stepping a finished game
+        if (std::abs(delta.head.x - from.x) + std::abs(delta.head.y - from.y) != 1) return false; //one step from the old head
+        if (!shape.inside(delta.head) && !over) return false; //only a head that ran into the border leaves the board
+        if (!(delta.flags & NetProtocol::TickDelta::TailMoved) && snakeBody.size() == snakeBody.capacity()) return false;
+        if ((delta.flags & NetProtocol::TickDelta::AppleMoved) && !shape.inside(delta.apple)) return false;
+        return true;
+    }
+
+    bool apply(uint32_t deltaTick, const NetProtocol::TickDelta& delta) { //false unless it is the very next tick and consistent
+        if (!ready() || deltaTick != tick + 1 || !consistent(delta)) return false;
+
+        if (delta.flags & NetProtocol::TickDelta::TailMoved) snakeBody.pop_back();
+        snakeBody.push_front(delta.head);
+        if (delta.flags & NetProtocol::TickDelta::AppleMoved) {
+            applePos = delta.apple;
+            appleSpawned = true;
+        }
+        if (delta.flags & NetProtocol::TickDelta::ScoreChanged) score = delta.score;
+        if (delta.flags & NetProtocol::TickDelta::Won) appleSpawned = false; //nowhere left to put one
+
+        lastFlags = delta.flags;
+        tick = deltaTick;
+        return true;
+    }
+};
@@ -0,0 +1,134 @@
+#include "NetSocket.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static bool startup() { //WSAStartup once per process, nothing to do elsewhere
+#if defined(_WIN32)
+    static bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+#else
+    return true;
+#endif
+}
+
+static sockaddr_in toSockaddr(const NetAddress& address) {
+    sockaddr_in out = {};
+    out.sin_family = AF_INET;
+    out.sin_addr.s_addr = htonl(address.ip);
+    out.sin_port = htons(address.port);
+    return out;
+}
+
+bool NetAddress::resolve(const char* host, uint16_t port, NetAddress& out) {
+    if (!startup()) return false;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return false;
+
+    out.ip = ntohl(((const sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    out.port = port;
+    freeaddrinfo(found);
+    return true;
+}
+
+bool NetAddress::parse(const char* hostPort, NetAddress& out) {
+    const char* colon = strrchr(hostPort, ':');
+    if (!colon) return false;
+
+    int port = atoi(colon + 1);
+    if (port <= 0 || port > 65535) return false;
+    return resolve(std::string(hostPort, colon).c_str(), port, out);
+}
+
+bool UdpSocket::open(uint16_t port) {
+    close();
+    if (!startup()) return false;
+
+    intptr_t fd = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#if defined(_WIN32)
+    if (fd == (intptr_t)INVALID_SOCKET) return false;
+    u_long nonBlocking = 1;
+    ioctlsocket((SOCKET)fd, FIONBIO, &nonBlocking);
+#else
+    if (fd < 0) return false;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    handle = fd;
+
+    sockaddr_in local = toSockaddr({INADDR_ANY, port});
+    if (bind(handle, (const sockaddr*)&local, sizeof(local)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocket::close() {
+    if (handle == -1) return;
+#if defined(_WIN32)
+    closesocket((SOCKET)handle);
+#else
+    ::close(handle);
+#endif
+    handle = -1;
+}
+
+bool UdpSocket::send(const NetAddress& to, const uint8_t* data, size_t size) {
+    sockaddr_in target = toSockaddr(to);
+    return sendto(handle, (const char*)data, size, 0, (const sockaddr*)&target, sizeof(target)) == (long)size;
+}
+
+int UdpSocket::receive(NetAddress& from, uint8_t* buffer, size_t capacity) {
+    sockaddr_in sender = {};
+    socklen_t senderSize = sizeof(sender);
+    long got = recvfrom(handle, (char*)buffer, capacity, 0, (sockaddr*)&sender, &senderSize);
+
+    if (got < 0) {
+#if defined(_WIN32)
+        int error = WSAGetLastError();
+        return error == WSAEWOULDBLOCK || error == WSAECONNRESET ? 0 : -1; //a reset is an earlier send to a closed port, not fatal
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED ? 0 : -1;
+#endif
+    }
+
+    from.ip = ntohl(sender.sin_addr.s_addr);
+    from.port = ntohs(sender.sin_port);
+    return got;
+}
+
+bool UdpSocket::wait(int milliseconds) {
+#if defined(_WIN32)
+    WSAPOLLFD entry = {(SOCKET)handle, POLLRDNORM, 0};
+    return WSAPoll(&entry, 1, milliseconds) > 0;
+#else
+    pollfd entry = {int(handle), POLLIN, 0};
+    return poll(&entry, 1, milliseconds) > 0;
+#endif
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+//non-blocking UDP socket for online play, the only code that touches the OS network API
+//the implementation lives in NetSocket.cpp so winsock2.h never meets raylib.h, they define clashing names on Windows
+
+#include <cstddef>
+#include <cstdint>
+
+struct NetAddress {
+    uint32_t ip = 0; //IPv4, host byte order
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+    uint64_t key() const { return uint64_t(ip) << 16 | port; } //for hashing sessions by sender
+
+    static bool resolve(const char* host, uint16_t port, NetAddress& out); //dotted quad or host name
+    static bool parse(const char* hostPort, NetAddress& out); //"host:port"
+};
+
+class UdpSocket {
+private:
+    intptr_t handle = -1;
+
+public:
+    UdpSocket() = default;
+    ~UdpSocket() { close(); }
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    bool open(uint16_t port = 0); //0 binds an ephemeral port, clients do that
+    void close();
+    bool good() const { return handle != -1; }
+
+    bool send(const NetAddress& to, const uint8_t* data, size_t size);
+    int receive(NetAddress& from, uint8_t* buffer, size_t capacity); //bytes read, 0 when nothing is pending, -1 on error
+    bool wait(int milliseconds); //until a datagram is pending or the timeout runs out
+};
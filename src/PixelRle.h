@@ -0,0 +1,69 @@
+#pragma once
+
+//run-length coding for 32-bit RGBA pixels, used by the baked asset pack (tools/bake_assets.cpp writes, AssetCache reads)
+//sprites are mostly flat colour and fully transparent border, so runs shrink them well and decode at memcpy speed
+//a control byte c is followed by either one pixel repeated (c & 0x7f) + 1 times when the top bit is set,
+//or by c + 1 literal pixels
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace PixelRle {
+    constexpr int maxRun = 128;
+
+    inline uint32_t pixelAt(const uint8_t* rgba, size_t i) {
+        uint32_t pixel;
+        memcpy(&pixel, rgba + i * 4, 4);
+        return pixel;
+    }
+
+    inline std::vector<uint8_t> encode(const uint8_t* rgba, size_t pixels) {
+        std::vector<uint8_t> out;
+        size_t i = 0;
+
+        while (i < pixels) {
+            size_t run = 1;
+            while (i + run < pixels && run < maxRun && pixelAt(rgba, i + run) == pixelAt(rgba, i)) run++;
+
+            if (run >= 2) {
+                out.push_back(uint8_t(0x80 | (run - 1)));
+                out.insert(out.end(), rgba + i * 4, rgba + i * 4 + 4);
+                i += run;
+                continue;
+            }
+
+            size_t literal = 1; //until the next pair of equal pixels, where a run pays off again
+            while (i + literal < pixels && literal < maxRun
+                && !(i + literal + 1 < pixels && pixelAt(rgba, i + literal) == pixelAt(rgba, i + literal + 1))) literal++;
+
+            out.push_back(uint8_t(literal - 1));
+            out.insert(out.end(), rgba + i * 4, rgba + (i + literal) * 4);
+            i += literal;
+        }
+        return out;
+    }
+
+    inline bool decode(const uint8_t* in, size_t size, uint8_t* rgba, size_t pixels) { //false on a truncated or oversized stream
+        size_t pos = 0, written = 0;
+
+        while (pos < size) {
+            uint8_t control = in[pos++];
+            size_t count = (control & 0x7f) + 1;
+            if (written + count > pixels) return false;
+
+            if (control & 0x80) {
+                if (pos + 4 > size) return false;
+                for (size_t i = 0; i < count; i++) memcpy(rgba + (written + i) * 4, in + pos, 4);
+                pos += 4;
+            }
+            else {
+                if (pos + count * 4 > size) return false;
+                memcpy(rgba + written * 4, in + pos, count * 4);
+                pos += count * 4;
+            }
+            written += count;
+        }
+        return written == pixels;
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+//frame-time instrumentation: scoped timers per hot section, per-frame counters and a short history for percentiles
+//compiled in only when SNAKE_PROFILING is defined before this header, otherwise the macros expand to nothing
+//single threaded, the front-end owns it; headless tools leave it off and pay nothing
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+class Profiler {
+public:
+    enum Section {Frame, Input, Tick, Collision, FoodSpawn, DrawBackground, DrawFood, DrawSnake, DrawHud, EndDrawing, SectionCount};
+    enum Counter {DrawCalls, Ticks, SpawnSamples, CounterCount};
+
+    static constexpr int historySize = 240; //four seconds at 60 fps
+    static constexpr int traceSize = 1 << 15; //most recent scoped events kept for the chrome trace dump
+
+private:
+    //all static as no object of this class will be made
+
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceEvent {
+        uint8_t section;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    static inline const Clock::time_point epoch = Clock::now();
+
+    static inline std::array<int64_t, SectionCount> frameNs = {}; //accumulated this frame
+    static inline std::array<int, CounterCount> frameCounters = {};
+
+    static inline std::array<std::array<int64_t, SectionCount>, historySize> sectionHistory = {};
+    static inline std::array<std::array<int, CounterCount>, historySize> counterHistory = {};
+    static inline int frameCount = 0;
+
+    static inline std::array<TraceEvent, traceSize> trace = {}; //ring, overwrites the oldest
+    static inline long long traceCount = 0;
+
+    static const char* name(int section) {
+        static constexpr const char* names[SectionCount] = {
+            "Frame", "Snake::Update", "SnakeSim::step", "CollisionHandler::handle", "SnakeSim::generateRandomPos",
+            "Background::Draw", "Food::Draw", "Snake::Draw", "ScoreBoard::Draw", "EndDrawing"
+        };
+        return names[section];
+    }
+
+public:
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+    }
+
+    static void record(Section section, int64_t startNs, int64_t endNs) {
+        frameNs[section] += endNs - startNs;
+        trace[traceCount++ % traceSize] = {uint8_t(section), startNs, endNs - startNs};
+    }
+
+    static void count(Counter counter, int amount = 1) {
+        frameCounters[counter] += amount;
+    }
+
+    static void endFrame() { //call once per frame after the Frame scope closed
+        int slot = frameCount++ % historySize;
+        sectionHistory[slot] = frameNs;
+        counterHistory[slot] = frameCounters;
+
+        frameNs = {};
+        frameCounters = {};
+    }
+
+    static int frames() { return std::min(frameCount, historySize); }
+
+    static double percentileMs(Section section, double percentile) { //over the recorded history, percentile in [0, 1]
+        int n = frames();
+        if (n == 0) return 0;
+
+        std::array<int64_t, historySize> samples;
+        for (int i = 0; i < n; i++) samples[i] = sectionHistory[i][section];
+
+        int k = std::min(n - 1, int(percentile * n));
+        std::nth_element(samples.begin(), samples.begin() + k, samples.begin() + n);
+        return samples[k] / 1e6;
+    }
+
+    static int lastCounter(Counter counter) {
+        return frameCount ? counterHistory[(frameCount - 1) % historySize][counter] : 0;
+    }
+
+    static bool dumpCsv(const char* path) { //one row per frame in the history window, times in microseconds
+        FILE* file = fopen(path, "w");
+        if (!file) return false;
+
+        fprintf(file, "frame");
+        for (int s = 0; s < SectionCount; s++) fprintf(file, ",%s_us", name(s));
+        fprintf(file, ",draw_calls,ticks,spawn_samples\n");
+
+        int n = frames();
+        for (int i = 0; i < n; i++) {
+            int frame = frameCount - n + i;
+            const auto& sections = sectionHistory[frame % historySize];
+            const auto& counters = counterHistory[frame % historySize];
+
+            fprintf(file, "%d", frame);
+            for (int s = 0; s < SectionCount; s++) fprintf(file, ",%.1f", sections[s] / 1e3);
+            fprintf(file, ",%d,%d,%d\n", counters[DrawCalls], counters[Ticks], counters[SpawnSamples]);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    static bool dumpChromeTrace(const char* path) { //open in chrome://tracing or ui.perfetto.dev
+        FILE* file = fopen(path, "w");
+        if (!file) return false;
+
+        long long first = std::max(0LL, traceCount - traceSize);
+        fprintf(file, "{\"traceEvents\":[\n");
+        for (long long i = first; i < traceCount; i++) {
+            const TraceEvent& event = trace[i % traceSize];
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n",
+                i == first ? "" : ",", name(event.section), event.startNs / 1e3, event.durationNs / 1e3);
+        }
+        fprintf(file, "]}\n");
+
+        fclose(file);
+        return true;
+    }
+};
+
+class ScopedTimer {
+private:
+    Profiler::Section section;
+    int64_t start;
+
+public:
+    ScopedTimer(Profiler::Section section) : section(section), start(Profiler::now()) {}
+    ~ScopedTimer() { Profiler::record(section, start, Profiler::now()); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#define SNAKE_PROFILE_CONCAT_INNER(a, b) a##b
+#define SNAKE_PROFILE_CONCAT(a, b) SNAKE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef SNAKE_PROFILING
+    #define SNAKE_PROFILE_SCOPE(section) ScopedTimer SNAKE_PROFILE_CONCAT(profileScope, __COUNTER__)(Profiler::section)
+    #define SNAKE_PROFILE_COUNT(counter, amount) Profiler::count(Profiler::counter, amount)
+#else
+    #define SNAKE_PROFILE_SCOPE(section) ((void)0)
+    #define SNAKE_PROFILE_COUNT(counter, amount) ((void)0)
+#endif
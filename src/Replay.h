@@ -0,0 +1,495 @@
+#pragma once
+
+//deterministic replays: a game is its seed plus the input handed to SnakeSim::step every tick, 2 bits per tick
+//keyframes of the full sim state every keyframeInterval ticks make seeking cheap, playback never has to start from tick 0
+//plain C++ only, the front-end records and plays these back and tools/replay.cpp runs them headless
+//
+//file layout, all integers little endian:
+//  header   "SNKR" u16 version u16 rows u16 cols u32 keyframeInterval u64 seed
+//  'I' u32 firstTick u32 count, then count inputs packed four to a byte, lowest bits first
+//  'K' u32 tick u32 size, then the sim state after that tick (StateCodec)
+//  'E' u32 ticks i32 score i32 length u8 won u8 over, written once the game ends
+//input and keyframe chunks alternate, so a file cut short by a crash still plays up to its last whole chunk
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "SnakeSim.h"
+
+class ByteWriter {
+private:
+    std::vector<uint8_t>& out;
+
+public:
+    ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void u8(uint8_t value) { out.push_back(value); }
+    void u16(uint16_t value) { for (int i = 0; i < 2; i++) out.push_back(value >> (8 * i)); }
+    void u32(uint32_t value) { for (int i = 0; i < 4; i++) out.push_back(value >> (8 * i)); }
+    void u64(uint64_t value) { for (int i = 0; i < 8; i++) out.push_back(value >> (8 * i)); }
+    void bytes(const uint8_t* data, size_t size) { out.insert(out.end(), data, data + size); }
+};
+
+class ByteReader {
+    //bounds checked, a short read sets failed() and returns zeros instead of reading past the end
+
+private:
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool overrun = false;
+
+    bool take(size_t size) {
+        if (overrun || size_t(end - pos) < size) {
+            overrun = true;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t little(int size) {
+        if (!take(size)) return 0;
+        uint64_t value = 0;
+        for (int i = 0; i < size; i++) value |= uint64_t(pos[i]) << (8 * i);
+        pos += size;
+        return value;
+    }
+
+public:
+    ByteReader(const uint8_t* data, size_t size) : pos(data), end(data + size) {}
+
+    uint8_t u8() { return little(1); }
+    uint16_t u16() { return little(2); }
+    uint32_t u32() { return little(4); }
+    uint64_t u64() { return little(8); }
+
+    const uint8_t* skip(size_t size) { //returns where the skipped bytes start, nullptr on overrun
+        if (!take(size)) return nullptr;
+        const uint8_t* start = pos;
+        pos += size;
+        return start;
+    }
+
+    bool failed() const { return overrun; }
+    bool atEnd() const { return pos == end; }
+    const uint8_t* cursor() const { return pos; }
+};
+
+class StateCodec {
+    //every field SnakeSim::step reads, including the free list order the next apple spawn depends on
+    //occupancy counts and free slots are rebuilt from the body and the free list rather than stored
+
+private:
+    static bool smallBoard(BoardSize board) { return board.cells() <= 1 << 16; } //free cell indices fit in 16 bits
+
+public:
+    static void write(const SnakeSim& sim, std::vector<uint8_t>& out) {
+        ByteWriter writer(out);
+
+        writer.u64(sim.rng.state);
+        writer.u8(uint8_t(sim.direction));
+        writer.u8(sim.addSegment | sim.appleSpawned << 1 | sim.hasMoved << 2 | sim.collision.boardFull << 3 | sim.collision.gameOver << 4);
+        writer.u16(sim.applePos.x);
+        writer.u16(sim.applePos.y);
+        writer.u16(sim.prevTail.x);
+        writer.u16(sim.prevTail.y);
+        writer.u32(sim.scoreBoard.score);
+        writer.u32(sim.scoreBoard.length);
+
+        writer.u32(sim.snakeBody.size());
+        sim.snakeBody.forEach([&](const Cell& segment) {
+            writer.u16(segment.x);
+            writer.u16(segment.y);
+        });
+
+        const std::vector<int>& freeCells = sim.occupancy.freeCells;
+        writer.u32(freeCells.size());
+        for (int cell : freeCells) {
+            if (smallBoard(sim.board)) writer.u16(cell);
+            else writer.u32(cell);
+        }
+    }
+
+    static bool read(SnakeSim& sim, const uint8_t* data, size_t size) { //sim must already be built for the right board
+        //decodes into scratch and only touches sim once the state is self-consistent, the bytes may come off the network
+        ByteReader reader(data, size);
+        BoardSize board = sim.board;
+        DynamicShape shape = {board.rows, board.cols};
+
+        uint64_t rngState = reader.u64();
+        Direction direction = Direction(reader.u8() & 3);
+        uint8_t flags = reader.u8();
+        Cell applePos = {int16_t(reader.u16()), int16_t(reader.u16())};
+        Cell prevTail = {int16_t(reader.u16()), int16_t(reader.u16())};
+        int score = reader.u32();
+        int scoreLength = reader.u32();
+
+        bool addSegment = flags & 1, appleSpawned = flags & 2, gameOver = flags & 16;
+
+        int length = reader.u32();
+        if (reader.failed() || length < 1 || length > board.cells()) return false;
+        if (addSegment && length == board.cells()) return false; //no cell left to grow into
+
+        SnakeBody body(board.cells());
+        std::vector<uint8_t> counts(board.cells(), 0); //rebuilt from the body, never trusted from the bytes
+        Cell head = {0, 0};
+
+        for (int i = 0; i < length; i++) {
+            Cell segment = {int16_t(reader.u16()), int16_t(reader.u16())};
+            body.push_back(segment);
+
+            if (i == 0) head = segment;
+            if (!shape.inside(segment)) {
+                if (i == 0 && gameOver) continue; //a head that ran into the border is the only cell ever off the board
+                return false;
+            }
+
+            uint8_t& count = counts[shape.index(segment)];
+            bool bitten = count == 1 && i > 0 && gameOver && segment == head; //the head on its own body, the tick it died
+            if (count > 1 || (count == 1 && !bitten)) return false;
+            count++;
+        }
+
+        if (!shape.inside(prevTail)) return false;
+        if (appleSpawned && (!shape.inside(applePos) || counts[shape.index(applePos)] != 0)) return false;
+
+        int freeCount = reader.u32();
+        int emptyCells = std::count(counts.begin(), counts.end(), 0);
+        if (reader.failed() || freeCount != emptyCells) return false; //the free list is exactly the cells nobody covers
+
+        std::vector<int> freeCells(freeCount);
+        std::vector<int> freeSlot(board.cells(), -1);
+        for (int slot = 0; slot < freeCount; slot++) {
+            int cell = smallBoard(board) ? reader.u16() : reader.u32();
+            if (cell >= board.cells() || counts[cell] != 0 || freeSlot[cell] != -1) return false; //with the count above, no cell is missed
+
+            freeSlot[cell] = slot;
+            freeCells[slot] = cell;
+        }
+        if (reader.failed()) return false;
+
+        sim.rng.state = rngState;
+        sim.direction = direction;
+        sim.addSegment = addSegment;
+        sim.appleSpawned = appleSpawned;
+        sim.hasMoved = flags & 4;
+        sim.collision.boardFull = flags & 8;
+        sim.collision.gameOver = gameOver;
+        sim.collision.foodEaten = false; //always consumed within the tick that set it
+        sim.applePos = applePos;
+        sim.prevTail = prevTail;
+        sim.scoreBoard.score = score;
+        sim.scoreBoard.length = scoreLength;
+
+        sim.snakeBody = std::move(body);
+        sim.occupancy.rebuild(sim.snakeBody, freeCells.data(), freeCount, freeSlot.data());
+        return true;
+    }
+};
+
+struct ReplayFormat {
+    static constexpr char magic[4] = {'S', 'N', 'K', 'R'};
+    static constexpr uint16_t version = 1;
+    static constexpr int headerSize = 4 + 2 + 2 + 2 + 4 + 8;
+    static constexpr int defaultKeyframeInterval = 1024; //a 16x16 keyframe is ~0.5KB against 256 bytes of input per interval
+
+    enum Chunk : uint8_t {Inputs = 'I', Keyframe = 'K', End = 'E'};
+};
+
+class ReplayWriter {
+    //streams a game out as it is played; call record() after every SnakeSim::step and finish() once it ended
+    //writes to a file, or without a path into memory (bytes()) for tools that batch replays into an archive
+
+private:
+    FILE* file = nullptr;
+    bool toMemory = false;
+    int keyframeInterval;
+
+    std::vector<uint8_t> chunk; //reused, only ever grows to one keyframe; holds the whole replay in memory mode
+    std::vector<uint8_t> pending; //packed inputs since the last keyframe
+    int pendingTicks = 0;
+    int ticks = 0;
+    bool finished = false;
+
+    void begin(uint64_t seed, BoardSize board) {
+        pending.reserve((keyframeInterval + 3) / 4);
+
+        ByteWriter writer(chunk);
+        writer.bytes((const uint8_t*)ReplayFormat::magic, 4);
+        writer.u16(ReplayFormat::version);
+        writer.u16(board.rows);
+        writer.u16(board.cols);
+        writer.u32(keyframeInterval);
+        writer.u64(seed);
+        emit(0);
+    }
+
+    void emit(size_t from) { //chunk[from, end) is one finished record
+        if (toMemory) return; //already in place
+        fwrite(chunk.data() + from, 1, chunk.size() - from, file);
+        chunk.clear();
+    }
+
+    void flushInputs() {
+        if (pendingTicks == 0) return;
+
+        size_t from = chunk.size();
+        ByteWriter writer(chunk);
+        writer.u8(ReplayFormat::Inputs);
+        writer.u32(ticks - pendingTicks);
+        writer.u32(pendingTicks);
+        writer.bytes(pending.data(), pending.size());
+        emit(from);
+
+        pending.clear();
+        pendingTicks = 0;
+    }
+
+public:
+    ReplayWriter(const char* path, uint64_t seed, BoardSize board, int keyframeInterval = ReplayFormat::defaultKeyframeInterval) :
+        keyframeInterval(keyframeInterval)
+    {
+        file = fopen(path, "wb");
+        if (file) begin(seed, board);
+    }
+
+    ReplayWriter(uint64_t seed, BoardSize board, int keyframeInterval = ReplayFormat::defaultKeyframeInterval) :
+        toMemory(true), keyframeInterval(keyframeInterval)
+    {
+        begin(seed, board);
+    }
+
+    ~ReplayWriter() {
+        if (!file) return;
+        if (!finished) flushInputs(); //window closed mid game, keep what was played
+        fclose(file);
+    }
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    bool good() const { return file || toMemory; }
+    int recorded() const { return ticks; }
+
+    const std::vector<uint8_t>& bytes() const { return chunk; } //memory mode only, complete after finish()
+
+    void record(Direction input, const SnakeSim& after) { //input exactly as it was passed to step(), reversals included
+        if (!good() || finished) return;
+
+        int bit = pendingTicks % 4 * 2;
+        if (bit == 0) pending.push_back(0);
+        pending.back() |= uint8_t(input) << bit;
+        pendingTicks++;
+        ticks++;
+
+        if (ticks % keyframeInterval == 0) {
+            flushInputs();
+
+            size_t from = chunk.size();
+            ByteWriter writer(chunk);
+            writer.u8(ReplayFormat::Keyframe);
+            writer.u32(ticks);
+            writer.u32(0); //size, patched below once the state is written
+            StateCodec::write(after, chunk);
+
+            uint32_t size = chunk.size() - from - 9;
+            for (int i = 0; i < 4; i++) chunk[from + 5 + i] = size >> (8 * i);
+            emit(from);
+        }
+    }
+
+    void finish(const SnakeSim& sim) { //end record with the result, lets players verify a claimed score
+        if (!good() || finished) return;
+        flushInputs();
+
+        size_t from = chunk.size();
+        ByteWriter writer(chunk);
+        writer.u8(ReplayFormat::End);
+        writer.u32(ticks);
+        writer.u32(sim.scores().getScore());
+        writer.u32(sim.scores().getLength());
+        writer.u8(sim.collisions().isBoardFull());
+        writer.u8(sim.isOver());
+        emit(from);
+        if (file) fflush(file);
+
+        finished = true;
+    }
+};
+
+class ReplayReader {
+    //indexes a replay held in memory, the bytes are not copied and must outlive the reader
+    //input(tick) is O(1), stateAt(tick) restores the nearest keyframe and steps at most keyframeInterval ticks
+
+public:
+    struct Result {
+        int ticks = 0;
+        int score = 0;
+        int length = 0;
+        bool won = false;
+        bool over = false;
+    };
+
+private:
+    struct Keyframe {
+        int tick;
+        const uint8_t* state;
+        uint32_t size;
+    };
+
+    const char* problem = "no replay opened";
+
+    BoardSize board;
+    uint64_t gameSeed = 0;
+    int keyframeInterval = 0;
+
+    std::vector<const uint8_t*> inputChunks; //chunk k holds ticks [k * keyframeInterval, (k + 1) * keyframeInterval)
+    std::vector<Keyframe> keyframes;
+    int tickCount = 0;
+
+    bool ended = false;
+    Result result;
+
+    bool fail(const char* why) {
+        problem = why;
+        return false;
+    }
+
+    bool parse(const uint8_t* data, size_t size) {
+        ByteReader reader(data, size);
+
+        const uint8_t* magic = reader.skip(4);
+        if (!magic || memcmp(magic, ReplayFormat::magic, 4) != 0) return fail("not a replay file");
+        if (reader.u16() != ReplayFormat::version) return fail("unsupported replay version");
+
+        board.rows = reader.u16();
+        board.cols = reader.u16();
+        keyframeInterval = reader.u32();
+        gameSeed = reader.u64();
+        if (reader.failed() || !board.valid() || keyframeInterval <= 0) return fail("corrupt header");
+
+        bool shortChunk = false; //only the last input chunk may hold fewer than keyframeInterval ticks
+
+        while (!reader.atEnd() && !ended) {
+            uint8_t tag = reader.u8();
+
+            if (tag == ReplayFormat::Inputs) {
+                int first = reader.u32();
+                int count = reader.u32();
+                const uint8_t* bits = reader.skip((size_t(count) + 3) / 4);
+                if (!bits || shortChunk || first != tickCount || count <= 0 || count > keyframeInterval) return fail("corrupt input chunk");
+
+                inputChunks.push_back(bits);
+                tickCount += count;
+                shortChunk = count < keyframeInterval;
+            }
+            else if (tag == ReplayFormat::Keyframe) {
+                int tick = reader.u32();
+                uint32_t stateSize = reader.u32();
+                const uint8_t* state = reader.skip(stateSize);
+                if (!state || tick != tickCount) return fail("corrupt keyframe");
+
+                keyframes.push_back({tick, state, stateSize});
+            }
+            else if (tag == ReplayFormat::End) {
+                result.ticks = reader.u32();
+                result.score = reader.u32();
+                result.length = reader.u32();
+                result.won = reader.u8();
+                result.over = reader.u8();
+                if (reader.failed() || result.ticks != tickCount) return fail("corrupt end record");
+                ended = true;
+            }
+            else return fail("unknown chunk");
+        }
+
+        return true;
+    }
+
+public:
+    ReplayReader() = default;
+
+    ReplayReader(const uint8_t* data, size_t size) {
+        open(data, size);
+    }
+
+    bool open(const uint8_t* data, size_t size) { //reuses the index storage, so hopping between archived games does not allocate
+        problem = nullptr;
+        board = {};
+        gameSeed = 0;
+        keyframeInterval = 0;
+        inputChunks.clear();
+        keyframes.clear();
+        tickCount = 0;
+        ended = false;
+        result = {};
+
+        return parse(data, size);
+    }
+
+    static bool loadFile(const char* path, std::vector<uint8_t>& bytes) {
+        FILE* file = fopen(path, "rb");
+        if (!file) return false;
+
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        bytes.resize(size > 0 ? size : 0);
+        bool complete = fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        fclose(file);
+        return complete;
+    }
+
+    bool valid() const { return problem == nullptr; }
+    const char* error() const { return problem ? problem : ""; }
+
+    BoardSize boardSize() const { return board; }
+    uint64_t seed() const { return gameSeed; }
+    int ticks() const { return tickCount; }
+    int interval() const { return keyframeInterval; }
+    int keyframeCount() const { return keyframes.size(); }
+
+    bool finished() const { return ended; } //false for a recording cut short, it plays up to ticks()
+    const Result& recordedResult() const { return result; }
+
+    Direction input(int tick) const { //tick in [0, ticks())
+        const uint8_t* bits = inputChunks[tick / keyframeInterval];
+        int local = tick % keyframeInterval;
+        return Direction(bits[local / 4] >> (local % 4 * 2) & 3);
+    }
+
+    SnakeSim start() const { return SnakeSim(gameSeed, board); }
+
+    SnakeSim stateAt(int tick) const { //state after tick inputs, clamped to [0, ticks()]
+        tick = std::clamp(tick, 0, tickCount);
+
+        SnakeSim sim = start();
+        int from = 0;
+
+        auto nearest = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+            [](int t, const Keyframe& keyframe) { return t < keyframe.tick; });
+
+        if (nearest != keyframes.begin()) {
+            const Keyframe& keyframe = *(nearest - 1);
+            if (StateCodec::read(sim, keyframe.state, keyframe.size)) from = keyframe.tick;
+            else sim = start(); //damaged keyframe, fall back to stepping from the start
+        }
+
+        for (int t = from; t < tick; t++) sim.step(input(t));
+        return sim;
+    }
+
+    bool verify(Result& replayed) const { //plays every input from the start, true when it reproduces the end record
+        SnakeSim sim = start();
+        for (int t = 0; t < tickCount; t++) sim.step(input(t));
+
+        replayed = {tickCount, sim.scores().getScore(), sim.scores().getLength(), sim.collisions().isBoardFull(), sim.isOver()};
+        if (!ended) return false;
+
+        return replayed.score == result.score && replayed.length == result.length
+            && replayed.won == result.won && replayed.over == result.over;
+    }
+};
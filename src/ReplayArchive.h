@@ -0,0 +1,403 @@
+#pragma once
+
+//archive of many replays in one file, for tournament servers that keep millions of games
+//replays are only ever appended; a fixed-size index entry per game (offset, size, seed, score, length, ticks) sits
+//in one block the header points at, so scanning scores touches only the index and jumping to a game is one lookup
+//readers mmap the file and use the index and replay bytes in place, no parsing of the whole file and no per-game allocation
+//
+//file layout, all integers little endian:
+//  header   64 bytes: "SNKA" u16 version u16 entrySize u64 indexOffset u64 gameCount u64 indexCapacity, zero padded
+//  replays  back to back, each exactly as Replay.h writes it
+//  index    a block of indexCapacity ArchiveEntry slots, 8-byte aligned, the first gameCount in use; replays
+//           appended later go after the block, so it can fill up in place
+//a commit writes the new entries into the free slots past gameCount, or once the block is full copies the index
+//to a new block of twice the size at the end of the file, syncs, and only then rewrites and syncs the header;
+//readers never look past gameCount, so a crash at any point leaves the header pointing at an intact index
+//a full block left behind is dead space, at most the size of the live index; compact() rewrites the archive tight
+//archives written before indexCapacity existed read it as zero, their index is taken as full and moved on the next commit
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h> //clashes with raylib names, keep this header out of Snake.cpp
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Replay.h"
+
+static_assert(std::endian::native == std::endian::little, "archive index entries are read in place from the mapping");
+
+struct ArchiveEntry {
+    //POD on disk layout, read straight out of the mapped index
+    uint64_t offset; //of the replay from the start of the file
+    uint64_t seed;
+    uint32_t size; //replay bytes
+    uint32_t ticks;
+    int32_t score;
+    int32_t length;
+    uint16_t rows;
+    uint16_t cols;
+    uint8_t flags; //Finished | Won | Over
+    uint8_t reserved[3];
+
+    enum Flag : uint8_t {Finished = 1, Won = 2, Over = 4};
+
+    bool finished() const { return flags & Finished; }
+    bool won() const { return flags & Won; }
+};
+
+static_assert(sizeof(ArchiveEntry) == 40, "on disk layout");
+
+struct ArchiveFormat {
+    static constexpr char magic[4] = {'S', 'N', 'K', 'A'};
+    static constexpr uint16_t version = 1;
+    static constexpr int headerSize = 64;
+};
+
+class MappedFile {
+    //read-only view of a whole file, unmapped on destruction
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    void close() {
+#if defined(_WIN32)
+        if (bytes) UnmapViewOfFile(bytes);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (bytes) munmap((void*)bytes, length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+public:
+    MappedFile() = default;
+
+    MappedFile(const char* path) {
+#if defined(_WIN32)
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return close();
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return close();
+
+        bytes = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!bytes) return close();
+        length = fileSize.QuadPart;
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (view != MAP_FAILED) {
+                bytes = (const uint8_t*)view;
+                length = info.st_size;
+            }
+        }
+        ::close(fd); //the mapping keeps the file alive
+#endif
+    }
+
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool good() const { return bytes != nullptr; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+class ReplayArchive {
+    //mapped, read-only; entries and replay bytes point into the mapping and stay valid while the archive lives
+
+private:
+    MappedFile file;
+    const ArchiveEntry* index = nullptr;
+    uint64_t gameCount = 0;
+    uint64_t indexStart = 0;
+    uint64_t capacity = 0;
+    const char* problem = nullptr;
+
+    bool fail(const char* why) {
+        problem = why;
+        index = nullptr;
+        gameCount = 0;
+        return false;
+    }
+
+    bool parse() {
+        if (!file.good()) return fail("cannot map file");
+
+        ByteReader reader(file.data(), file.size());
+        const uint8_t* magic = reader.skip(4);
+        if (!magic || memcmp(magic, ArchiveFormat::magic, 4) != 0) return fail("not a replay archive");
+        if (reader.u16() != ArchiveFormat::version) return fail("unsupported archive version");
+        if (reader.u16() != sizeof(ArchiveEntry)) return fail("unexpected index entry size");
+
+        uint64_t indexOffset = reader.u64();
+        uint64_t count = reader.u64();
+        capacity = std::max(reader.u64(), count);
+        indexStart = indexOffset;
+        if (reader.failed() || indexOffset % alignof(ArchiveEntry) != 0 || indexOffset > file.size()
+            || count > (file.size() - indexOffset) / sizeof(ArchiveEntry)) return fail("corrupt header");
+
+        index = (const ArchiveEntry*)(file.data() + indexOffset);
+        gameCount = count;
+
+        for (uint64_t i = 0; i < gameCount; i++) { //cheap, touches only the index, and lets replay() skip bounds checks
+            if (index[i].offset > file.size() || index[i].size > file.size() - index[i].offset) return fail("index points past the end");
+        }
+        return true;
+    }
+
+public:
+    ReplayArchive(const char* path) : file(path) {
+        parse();
+    }
+
+    bool valid() const { return problem == nullptr; }
+    const char* error() const { return problem ? problem : ""; }
+
+    uint64_t size() const { return gameCount; }
+    uint64_t indexOffset() const { return indexStart; }
+    uint64_t indexCapacity() const { return capacity; } //slots in the index block, at least size()
+    uint64_t deadBytes() const { //left behind by outgrown index blocks and torn appends, what compact() would reclaim
+        uint64_t live = ArchiveFormat::headerSize + std::min<uint64_t>(capacity * sizeof(ArchiveEntry), file.size() - indexStart); //free slots at the end are a hole
+        for (const ArchiveEntry& game : *this) live += game.size;
+        return file.size() > live ? file.size() - live : 0;
+    }
+
+    const ArchiveEntry& entry(uint64_t game) const { return index[game]; }
+    const ArchiveEntry* begin() const { return index; }
+    const ArchiveEntry* end() const { return index + gameCount; }
+
+    const uint8_t* replayData(uint64_t game) const { return file.data() + index[game].offset; }
+
+    bool replay(uint64_t game, ReplayReader& reader) const { //reopens a caller-owned reader, no copy of the replay bytes
+        return reader.open(replayData(game), index[game].size);
+    }
+};
+
+class ReplayArchiveWriter {
+    //appends replays to a new or existing archive; the index is written on commit() and on destruction
+
+private:
+    FILE* file = nullptr;
+    std::vector<ArchiveEntry> entries; //existing index plus everything appended since
+    uint64_t committed = 0; //entries the header counts
+    uint64_t indexOffset = ArchiveFormat::headerSize; //block the header points at, no slots until the first commit
+    uint64_t indexCapacity = 0;
+    uint64_t writeOffset = 0; //where the next replay goes, past the file end and past the index block
+    bool dirty = false;
+
+    static constexpr uint64_t minIndexCapacity = 1024;
+
+    std::vector<uint8_t> scratch;
+    ReplayReader reader; //reused to pull the index fields out of each appended replay
+
+    void seek(uint64_t offset) { //archives pass 2GB, plain fseek takes a 32-bit long on Windows
+#if defined(_WIN32)
+        _fseeki64(file, offset, SEEK_SET);
+#else
+        fseeko(file, offset, SEEK_SET);
+#endif
+    }
+
+    uint64_t fileEnd() {
+#if defined(_WIN32)
+        _fseeki64(file, 0, SEEK_END);
+        return _ftelli64(file);
+#else
+        fseeko(file, 0, SEEK_END);
+        return ftello(file);
+#endif
+    }
+
+    bool sync() { //through to the device, fflush alone only reaches the OS and orders nothing on disk
+        if (fflush(file) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    bool writeAt(uint64_t offset, const void* data, size_t size) {
+        seek(offset);
+        return fwrite(data, 1, size, file) == size;
+    }
+
+    bool writeHeader(uint64_t offset, uint64_t count, uint64_t capacity) {
+        scratch.assign(ArchiveFormat::headerSize, 0);
+        memcpy(scratch.data(), ArchiveFormat::magic, 4);
+
+        std::vector<uint8_t> fields;
+        ByteWriter writer(fields);
+        writer.u16(ArchiveFormat::version);
+        writer.u16(sizeof(ArchiveEntry));
+        writer.u64(offset);
+        writer.u64(count);
+        writer.u64(capacity);
+        memcpy(scratch.data() + 4, fields.data(), fields.size());
+
+        return writeAt(0, scratch.data(), scratch.size());
+    }
+
+    bool loadExisting(const char* path) {
+        ReplayArchive existing(path);
+        if (!existing.valid()) return false;
+
+        entries.assign(existing.begin(), existing.end());
+        committed = entries.size();
+        indexOffset = existing.indexOffset();
+        indexCapacity = existing.indexCapacity();
+        return true;
+    }
+
+public:
+    ReplayArchiveWriter(const char* path) {
+        file = fopen(path, "r+b");
+
+        if (file) {
+            if (!loadExisting(path)) { //refuse to append to something that is not an archive
+                fclose(file);
+                file = nullptr;
+                return;
+            }
+            writeOffset = std::max(fileEnd(), indexOffset + indexCapacity * sizeof(ArchiveEntry)); //the block may end in a hole
+        }
+        else {
+            file = fopen(path, "w+b");
+            if (!file) return;
+
+            writeOffset = ArchiveFormat::headerSize;
+            if (!writeHeader(indexOffset, 0, 0) || !sync()) {
+                fclose(file);
+                file = nullptr;
+            }
+        }
+    }
+
+    ~ReplayArchiveWriter() {
+        if (!file) return;
+        commit();
+        fclose(file);
+    }
+
+    ReplayArchiveWriter(const ReplayArchiveWriter&) = delete;
+    ReplayArchiveWriter& operator=(const ReplayArchiveWriter&) = delete;
+
+    bool good() const { return file != nullptr; }
+    uint64_t size() const { return entries.size(); }
+
+    bool append(const uint8_t* replay, size_t size) { //a complete replay as Replay.h writes it
+        if (!file || !reader.open(replay, size)) return false;
+
+        ArchiveEntry entry = {};
+        entry.offset = writeOffset;
+        entry.seed = reader.seed();
+        entry.size = size;
+        entry.ticks = reader.ticks();
+        entry.rows = reader.boardSize().rows;
+        entry.cols = reader.boardSize().cols;
+
+        if (reader.finished()) {
+            const ReplayReader::Result& result = reader.recordedResult();
+            entry.score = result.score;
+            entry.length = result.length;
+            entry.flags = ArchiveEntry::Finished | (result.won ? ArchiveEntry::Won : 0) | (result.over ? ArchiveEntry::Over : 0);
+        }
+
+        if (!writeAt(writeOffset, replay, size)) return false;
+
+        writeOffset += size;
+        entries.push_back(entry);
+        dirty = true;
+        return true;
+    }
+
+    bool append(const std::vector<uint8_t>& replay) { return append(replay.data(), replay.size()); }
+
+    bool commit() { //index entries synced, then the header; readers see all appends or none, false leaves the old index in force
+        if (!file) return false;
+        if (!dirty) return true;
+
+        uint64_t offset = indexOffset, capacity = indexCapacity;
+        bool written;
+
+        if (entries.size() <= capacity) { //free slots left, only the new entries are written
+            written = writeAt(offset + committed * sizeof(ArchiveEntry), entries.data() + committed, (entries.size() - committed) * sizeof(ArchiveEntry));
+        }
+        else { //outgrown: the whole index into a new block at the end, doubling keeps the copies amortised O(1) per game
+            offset = (writeOffset + alignof(ArchiveEntry) - 1) / alignof(ArchiveEntry) * alignof(ArchiveEntry);
+            capacity = std::max({minIndexCapacity, 2 * capacity, 2 * uint64_t(entries.size())});
+            written = writeAt(offset, entries.data(), entries.size() * sizeof(ArchiveEntry)); //the free slots stay a hole
+        }
+
+        if (!written || !sync()) return false; //replays and entries on disk before the header may point at them
+        if (!writeHeader(offset, entries.size(), capacity) || !sync()) return false;
+
+        indexOffset = offset;
+        indexCapacity = capacity;
+        committed = entries.size();
+        writeOffset = std::max(writeOffset, offset + capacity * sizeof(ArchiveEntry)); //later replays go past the block
+        dirty = false;
+        return true;
+    }
+
+    static bool compact(const char* path) { //rewrites the archive with only its live replays and a tight index, then renames it into place
+        std::string temp = std::string(path) + ".tmp";
+        std::error_code error;
+        std::filesystem::remove(temp, error);
+
+        bool written;
+        {
+            ReplayArchive source(path);
+            if (!source.valid()) return false;
+
+            ReplayArchiveWriter out(temp.c_str());
+            written = out.good();
+            for (uint64_t game = 0; written && game < source.size(); game++) {
+                written = out.append(source.replayData(game), source.entry(game).size);
+            }
+            written = written && out.commit();
+        } //both files closed before the rename, Windows refuses to replace an open or mapped file
+
+        if (written) std::filesystem::rename(temp, path, error);
+        if (!written || error) {
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+        return true;
+    }
+};
@@ -1,15 +1,113 @@
+#define SNAKE_PROFILING //timers compiled in, the overlay is toggled at runtime; remove to compile them out
+
 #include <raylib.h>
 #include <raymath.h>
 #include <string>
-#include <deque>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <future>
+#include <unordered_map>
+
+#include "SnakeSim.h"
+#include "Replay.h"
+#include "PixelRle.h"
+#include "NetPrediction.h"
+#include "Autopilot.h"
+#include "StatsStore.h"
+
+#if __has_include("generated/AssetPack.h") //written by make assets, without it textures load from Graphics/
+#include "generated/AssetPack.h"
+#define SNAKE_ASSET_PACK
+#endif
 
-constexpr int gridWidth = 800;
-constexpr int gridHeight = 800;
 constexpr int offset = 50;
+constexpr int hudHeight = 50;
+constexpr int maxGridPixels = 800; //board is scaled to fit this square, 16x16 keeps the original 50px cells
+
+//screen geometry follows the board picked at startup, set once by GameSettings::gameInit()
+inline BoardSize board = defaultBoard;
+inline int cellSize = 50;
+inline int gridWidth = 800;
+inline int gridHeight = 800;
+
+inline Vector2 toPixel(const Cell& cell) { //top-left corner of the cell on screen
+    return {float(offset + cell.x * cellSize), float(offset + cell.y * cellSize)};
+}
+
+inline Vector2 toPixel(const SegmentPosition& position) { //same for a segment caught between two cells
+    return {offset + position.x * cellSize, offset + position.y * cellSize};
+}
+
+class FramePacer {
+    //decides each loop whether a frame is worth drawing; when it is not, input is still polled and the sim still ticks
+    //Fixed is the original always-60 loop, Adaptive draws only while something moves, Vsync is Adaptive uncapped to the display
+    friend class GameSettings;
+
+public:
+    enum class Mode {Fixed, Adaptive, Vsync};
+
+private:
+    //all static as no object of this class will be made
+
+    static inline Mode mode = Mode::Adaptive;
+
+    static constexpr int activeFps = 60; //cap while the snake slides, Vsync leaves it to the display
+    static constexpr int flashFps = 30; //game over text, plenty for a slow fade
+    static constexpr int unfocusedFps = 10;
+    static constexpr int minimizedFps = 2; //only reached with FLAG_WINDOW_ALWAYS_RUN, raylib otherwise blocks while minimized
+    static constexpr double pollInterval = 1.0 / 120; //idle input latency while focused
 
-constexpr int cellSize = 50;
-constexpr float rows = gridHeight / cellSize;
-constexpr float cols = gridWidth / cellSize;
+    static inline double lastFrame = -1;
+    static inline bool pending = true; //something changed that no drawn frame has shown yet, starts true for the first frame
+
+    static void beforeWindow() {
+        if (mode == Mode::Vsync) SetConfigFlags(FLAG_VSYNC_HINT);
+    }
+
+    static void afterWindow() {
+        SetTargetFPS(mode == Mode::Vsync ? 0 : activeFps); //EndDrawing still caps the frames that are drawn
+    }
+
+    static double minGap() { //seconds between drawn frames
+        if (IsWindowMinimized()) return 1.0 / minimizedFps;
+        if (!IsWindowFocused()) return 1.0 / unfocusedFps;
+        return mode == Mode::Vsync ? 0 : 1.0 / activeFps;
+    }
+
+public:
+    static Mode parse(const std::string& name) {
+        if (name == "fixed") return Mode::Fixed;
+        if (name == "vsync") return Mode::Vsync;
+        return Mode::Adaptive;
+    }
+
+    static void setMode(Mode pacing) { mode = pacing; } //before GameSettings::gameInit()
+
+    static bool shouldDraw(bool changed, bool animating, bool flashing) {
+        //changed: the sim ticked or the view moved this loop; animating: every frame differs (interpolation, overlay)
+        if (mode == Mode::Fixed) return true;
+
+        double now = GetTime();
+        pending = pending || changed;
+
+        bool wanted = pending || animating || (flashing && now - lastFrame >= 1.0 / flashFps);
+        if (!wanted || now - lastFrame < minGap()) return false;
+
+        lastFrame = now;
+        pending = false;
+        return true;
+    }
+
+    static void idle(double untilTick) { //nothing drawn this loop: sleep to the next tick or poll, whichever is sooner
+        if (IsWindowResized()) pending = true;
+
+        double poll = IsWindowFocused() ? pollInterval : 1.0 / unfocusedFps;
+        WaitTime(std::clamp(untilTick, 0.0, poll));
+        PollInputEvents(); //EndDrawing normally does this, no key press is lost while frames are skipped
+    }
+};
 
 class GameSettings {
     friend class Snake;
@@ -35,9 +133,15 @@ private:
     }
 
 public:
-    static void gameInit() {
-        InitWindow(900, 950, "Snake");
-        SetTargetFPS(60);
+    static void gameInit(BoardSize boardSize) {
+        board = boardSize;
+        cellSize = std::max(1, maxGridPixels / std::max(board.rows, board.cols));
+        gridWidth = board.cols * cellSize;
+        gridHeight = board.rows * cellSize;
+
+        FramePacer::beforeWindow();
+        InitWindow(gridWidth + 2 * offset, gridHeight + 2 * offset + hudHeight, "Snake"); //900x950 on the default board
+        FramePacer::afterWindow();
     }
 };
 
@@ -50,284 +154,861 @@ private:
 
     static inline constexpr int borderCorrection = 8;
 
-    static inline const Rectangle borderRectangle = {
-        offset - borderCorrection, 
-        offset - borderCorrection, 
-        gridWidth + 2 * borderCorrection,
-        gridHeight + 2 * borderCorrection
-    };
-    //not constexpr as value is being defined at runtime
+    static Rectangle borderRectangle() { //follows the board size picked at startup
+        return {
+            offset - borderCorrection, 
+            offset - borderCorrection, 
+            float(gridWidth + 2 * borderCorrection),
+            float(gridHeight + 2 * borderCorrection)
+        };
+    }
 
-public:
-    static void Draw() {
-        ClearBackground(BackgroundColor);
+    static inline constexpr int minGridLineCell = 4; //below this the lines would cover the cells, draw a plain board
 
-        DrawRectangleLinesEx(borderRectangle, 8, BLACK); 
+    static inline RenderTexture2D layer = {0}; //grid never changes, so it is drawn once here and blitted every frame
+
+    static void bake() {
+        layer = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+
+        BeginTextureMode(layer);
+        ClearBackground(ColorAlpha(BackgroundColor, 1)); 
+        //opaque, window framebuffer alpha was never shown so this matches what the screen got before
+
+        DrawRectangleLinesEx(borderRectangle(), 8, BLACK); 
         //Ex gives more control over regular function
 
-        for (int i = 0; i <= rows; i++) {
-            DrawLine(offset, offset + i * cellSize, offset + cols * cellSize, offset + i * cellSize, GridColor);
+        if (cellSize >= minGridLineCell) {
+            for (int i = 0; i <= board.rows; i++) {
+                DrawLine(offset, offset + i * cellSize, offset + board.cols * cellSize, offset + i * cellSize, GridColor);
+            }
+
+            for (int j = 0; j <= board.cols; j++) {
+                DrawLine(offset + j * cellSize, offset, offset + j * cellSize, offset + board.rows * cellSize, GridColor);
+            }
         }
 
-        for (int j = 0; j <= cols; j++) {
-            DrawLine(offset + j * cellSize, offset, offset + j * cellSize, offset + rows * cellSize, GridColor);
+        EndTextureMode();
+    }
+
+public:
+    static void load() { //needs the window, call after GameSettings::gameInit()
+        bake();
+    }
+
+    static void unload() {
+        UnloadRenderTexture(layer);
+        layer = {0};
+    }
+
+    static Rectangle hudArea() { //everything below the border, where ScoreBoard draws
+        float top = offset + gridHeight + borderCorrection;
+        return {0, top, float(GetScreenWidth()), GetScreenHeight() - top};
+    }
+
+    static void DrawRegion(Rectangle area) { //repaints just this part of the screen, used to erase single cells
+        Rectangle source = {area.x, layer.texture.height - area.y - area.height, area.width, -area.height}; //flipped like Draw()
+        DrawTextureRec(layer.texture, source, {area.x, area.y}, WHITE);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
+    }
+
+    static void refresh() { //rebakes after a resize, outside any texture mode
+        if (IsWindowResized()) {
+            unload();
+            bake();
         }
+    }
+
+    static void Draw() {
+        refresh();
 
+        //render textures are stored bottom up in OpenGL, negative height flips it back
+        Rectangle source = {0, 0, float(layer.texture.width), -float(layer.texture.height)};
+        DrawTextureRec(layer.texture, source, {0, 0}, WHITE); //single quad, also replaces ClearBackground
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
     }
 };
 
-class Food {
-    friend class CollisionHandler;
+class AssetCache {
+    //load-once: textures are decoded once per (path, size), shared by every user and kept until clear() at exit,
+    //so new games skip disk and GPU upload; the few sprites the game uses are never worth evicting early
+    //decoding and resizing run on a worker thread; the GPU upload has to happen on the main thread, in poll()
+    //users hold a Handle and draw a placeholder until ready() turns true, a handle outliving clear() just stays not ready
 
 private:
-    Color FoodColor = {255, 50, 50, 191};
-    Texture2D appleTexture; //to access it both in constructor and destructor
-    Vector2 applePos;
-    std::deque<Vector2> snakeBody;
+    //all static as no object of this class will be made
+
+    struct Entry {
+        std::string path;
+        int width, height;
+        std::future<Image> decoding; //valid until the image is uploaded
+        Texture2D texture = {0};
+        bool ready = false;
+        bool failed = false;
+    };
 
-    void handleTexture() {
-        Image appleImg = LoadImage("Graphics/Apple.png"); //loads image to RAM
-        ImageResize(&appleImg, cellSize, cellSize);
+    static inline std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
 
-        appleTexture = LoadTextureFromImage(appleImg); //load from RAM to GPU VRAM for performance
-        UnloadImage(appleImg); //remove image from RAM after VRAM stores it as texture
+    static Image decode(const std::string& path, int width, int height) { //CPU only, safe off the main thread
+        Image image = LoadImage(path.c_str()); //loads image to RAM
+        if (image.data) ImageResize(&image, width, height);
+        return image;
     }
 
-    bool shouldGenerateAgain(const std::deque<Vector2>& snakeBody, const Vector2& pos) const {
-        for (auto body : snakeBody) if (pos == body) return true; //if random pos aligns on snake body, generate pos again 
+    static bool unpack(const std::string& path, int width, int height, Image& image) { //baked copy, no file access or PNG decode
+#ifdef SNAKE_ASSET_PACK
+        const PackedImage* best = nullptr; //exact size, else the largest bake to scale from
+        for (const PackedImage& packed : packedImages) {
+            if (path != packed.path) continue;
+            if (packed.width == width && packed.height == height) {
+                best = &packed;
+                break;
+            }
+            if (!best || packed.width > best->width) best = &packed;
+        }
+        if (!best) return false;
+
+        size_t pixels = size_t(best->width) * best->height;
+        image = {MemAlloc(pixels * 4), best->width, best->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        if (!PixelRle::decode(best->data, best->size, (uint8_t*)image.data, pixels)) {
+            UnloadImage(image);
+            return false;
+        }
+
+        if (best->width != width || best->height != height) ImageResize(&image, width, height); //board not at the default cell size
+        return true;
+#else
         return false;
+#endif
+    }
+
+    static bool upload(Entry& entry, Image image) {
+        if (!image.data) {
+            TraceLog(LOG_WARNING, "ASSETS: could not load %s, keeping the placeholder", entry.path.c_str());
+            entry.failed = true;
+            return false;
+        }
+
+        entry.texture = LoadTextureFromImage(image); //load from RAM to GPU VRAM for performance
+        UnloadImage(image); //remove image from RAM after VRAM stores it as texture
+        entry.ready = true;
+        return true;
     }
 
-    Vector2 generateRandomPos(const std::deque<Vector2>& snakeBody) {
-        Vector2 pos;
+public:
+    class Handle {
+        friend class AssetCache;
+
+    private:
+        std::shared_ptr<Entry> entry;
+
+        Handle(std::shared_ptr<Entry> entry) : entry(std::move(entry)) {}
+
+    public:
+        Handle() = default;
+
+        bool ready() const { return entry && entry->ready; }
+        const Texture2D& texture() const { return entry->texture; } //only once ready()
+    };
+
+    static Handle acquire(const std::string& path, int width, int height) {
+        std::string key = path + "@" + std::to_string(width) + "x" + std::to_string(height);
 
-        do {
-        float randX = GetRandomValue(0, rows - 1);//both inclusive
-        float randY = GetRandomValue(0, cols - 1);
+        auto found = entries.find(key);
+        if (found != entries.end()) return Handle(found->second);
 
-        pos = {randX * cellSize + offset, randY * cellSize + offset};
+        auto entry = std::make_shared<Entry>();
+        entry->path = path;
+        entry->width = width;
+        entry->height = height;
 
-        } while (shouldGenerateAgain(snakeBody, pos)); //do while loop instead of recursion avoids stack overflow as snake grows
+        Image packed;
+        if (unpack(path, width, height, packed)) upload(*entry, packed); //already decoded, ready on the first frame
+        else entry->decoding = std::async(std::launch::async, decode, path, width, height);
 
-        return pos;
+        entries[key] = entry;
+        return Handle(entry);
     }
 
-public:
-    Food(const std::deque<Vector2>& snakeBody) {
-        handleTexture();
-        this -> snakeBody = snakeBody;
-        applePos = generateRandomPos(snakeBody); 
+    static bool poll() { //main thread, once per loop; true when a texture became ready
+        bool uploaded = false;
+
+        for (auto& [key, entry] : entries) {
+            if (!entry->decoding.valid()) continue;
+            if (entry->decoding.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+
+            uploaded |= upload(*entry, entry->decoding.get());
+        }
+        return uploaded;
     }
 
-    ~Food() {
-        UnloadTexture(appleTexture); //remove from VRAM as well once finished
+    static void clear() { //before CloseWindow, handles still alive afterwards just stay not ready
+        for (auto& [key, entry] : entries) {
+            if (entry->decoding.valid()) {
+                Image image = entry->decoding.get(); //waits for the worker, nothing may outlive the window
+                if (image.data) UnloadImage(image);
+            }
+
+            if (entry->ready) UnloadTexture(entry->texture); //remove from VRAM as well once finished
+            entry->texture = {0};
+            entry->ready = false;
+        }
+        entries.clear();
     }
+};
 
-    void Draw() const {
-        DrawTexture(appleTexture, applePos.x, applePos.y, WHITE);//white means no tint on image
+class Food {
+private:
+    Color FoodColor = {255, 50, 50, 191}; //placeholder while the apple texture is still loading
+    AssetCache::Handle appleTexture;
+
+public:
+    Food() : appleTexture(AssetCache::acquire("Graphics/Apple.png", cellSize, cellSize)) {}
+
+    void Draw(const SnakeSim& sim) const {
+        if (!sim.hasApple()) return;
+
+        Vector2 pixel = toPixel(sim.apple());
+        if (appleTexture.ready()) DrawTextureV(appleTexture.texture(), pixel, WHITE);//white means no tint on image
+        else DrawRectangleRounded({pixel.x, pixel.y, float(cellSize), float(cellSize)}, 0.5, 10, FoodColor);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
     }
 };
 
 class Snake {
-    friend class CollisionHandler;
+    //input and drawing only, movement and collisions happen in SnakeSim
     friend class GameCore;
 
 private:
-   GameSettings::Difficulty difficulty;
+    GameSettings::Difficulty difficulty;
 
-   double interval = GameSettings::getInterval(difficulty);
+    double interval = GameSettings::getInterval(difficulty);
 
-   bool addSegment = false;
+    TurnQueue turns; //filled from key press events every frame, drained one turn per tick
 
-    std::deque<Vector2> snakeBody = { //O(1) operations for deque!
-        Vector2{((cols * cellSize) / 2 - cellSize), ((rows * cellSize) / 2 - cellSize)}, 
-        Vector2{((cols * cellSize) / 2), ((rows * cellSize) / 2 - cellSize)}
-    };
+    RenderTexture2D segmentSprite; //one rounded segment tessellated once, every segment is then a quad of this texture
+    //quads sharing a texture land in one raylib batch, so drawing cost barely grows with length
 
-    Vector2 lastDirection = {-1, 0};//first time for default value later to be updated
+    void handleSprite() {
+        segmentSprite = LoadRenderTexture(cellSize, cellSize);
 
-    Vector2 getMoveDirection() {
-        if (IsKeyDown(KEY_W) && lastDirection.y != 1) lastDirection = {0, -1};
-        else if (IsKeyDown(KEY_S) && lastDirection.y != -1) lastDirection = {0, 1};
-        else if (IsKeyDown(KEY_A) && lastDirection.x != 1) lastDirection = {-1, 0};
-        else if (IsKeyDown(KEY_D) && lastDirection.x != -1) lastDirection = {1, 0};
+        BeginTextureMode(segmentSprite);
+        ClearBackground(BLANK);
+        DrawRectangleRounded({0, 0, float(cellSize), float(cellSize)}, 0.5, 10, PURPLE);
+        EndTextureMode();
+    }
+
+    void getMoveDirection(Direction heading) {
+        //GetKeyPressed drains every press raylib's event callbacks queued since the last frame, in order
+        //so presses between two polls are never lost, unlike sampling IsKeyDown once per frame
+        for (int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+            switch (key) {
+                case KEY_W : turns.push(Direction::Up, heading); break;
+                case KEY_S : turns.push(Direction::Down, heading); break;
+                case KEY_A : turns.push(Direction::Left, heading); break;
+                case KEY_D : turns.push(Direction::Right, heading); break;
+            }
+        }
+    }
 
-        return (lastDirection * cellSize);
+    Direction nextTurn(Direction heading) {
+        return turns.next(heading);
     }
 
-    void moveSnake(const Vector2& direction){
-        snakeBody.push_front(Vector2Add(snakeBody[0], direction));
+public:
+    Snake(GameSettings::Difficulty difficulty) : difficulty(difficulty) {
+        handleSprite();
+    }
 
-        if (addSegment) addSegment = false;
-        else snakeBody.pop_back();
-        //when addSegment is true we just dont pop back for that frame, adding a segment
+    ~Snake() {
+        UnloadRenderTexture(segmentSprite);
     }
 
+    void Draw(const SnakeSim& sim, float alpha) const { //alpha in [0, 1], how far render time is between the last tick and the next
+        Rectangle source = {0, 0, float(cellSize), -float(cellSize)}; //render textures are stored bottom up
+
+        forEachSegmentPosition(sim, alpha, [&](const SegmentPosition& position) {
+            DrawTextureRec(segmentSprite.texture, source, toPixel(position), WHITE);
+        });
+        SNAKE_PROFILE_COUNT(DrawCalls, sim.body().size());
+    }
+
+    void DrawCell(const Cell& cell) const { //one segment snapped to its cell, no interpolation
+        Rectangle source = {0, 0, float(cellSize), -float(cellSize)};
+        DrawTextureRec(segmentSprite.texture, source, toPixel(cell), WHITE);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
+    }
+
+    void Update(Direction heading) {
+        getMoveDirection(heading); //input is sampled every frame, movement only happens on ticks
+    }
+};
+
+class TextSprite {
+    //one line of HUD text laid out once into a texture, every frame after is a single quad of it
+    //drawn white and tinted at draw time, so a flashing or recoloured label never needs a rebuild
+    //update() re-lays it out only when the value it shows changes; it switches render targets, so call it
+    //outside any texture mode, like Background::refresh()
+
+private:
+    RenderTexture2D target = {0};
+    int fontSize;
+    int textWidth = 0;
+    int shownValue = 0;
+
 public:
-    Snake(GameSettings::Difficulty difficulty) : difficulty(difficulty) {}
+    TextSprite(int fontSize) : fontSize(fontSize) {}
 
-    void Draw() const {
-        for (const Vector2 segment : snakeBody) {
-            Rectangle snakeRect = {segment.x, segment.y, cellSize, cellSize};
-            DrawRectangleRounded(snakeRect, 0.5, 10, PURPLE);
-        }
+    ~TextSprite() {
+        if (target.id) UnloadRenderTexture(target);
     }
 
-    void Update() {
-        static double lastUpdateTime = 0;
-        double currentTime = GetTime();
+    TextSprite(const TextSprite&) = delete;
+    TextSprite& operator=(const TextSprite&) = delete;
 
-        Vector2 direction = getMoveDirection();
+    void update(const char* format, int value = 0) { //format sees value as its only argument, static labels ignore it
+        if (target.id && value == shownValue) return;
 
-        if (currentTime - lastUpdateTime >= interval) {
-            moveSnake(direction);
-            lastUpdateTime = currentTime;
+        const char* text = TextFormat(format, value); //raylib's static buffer, nothing allocated
+        textWidth = std::max(1, MeasureText(text, fontSize));
+        shownValue = value;
+
+        if (target.texture.width < textWidth) { //only ever grows, a shorter number reuses the same texture
+            if (target.id) UnloadRenderTexture(target);
+            target = LoadRenderTexture(textWidth, fontSize);
         }
+
+        BeginTextureMode(target);
+        ClearBackground(BLANK);
+        DrawText(text, 0, 0, fontSize, WHITE);
+        EndTextureMode();
+    }
+
+    int width() const { return textWidth; }
+
+    void Draw(float x, float y, Color tint) const {
+        Rectangle source = {0, 0, float(textWidth), -float(fontSize)}; //render textures are stored bottom up
+        DrawTextureRec(target.texture, source, {x, y}, tint);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
     }
 };
 
-class CollisionHandler {
-    friend class GameCore;
-    friend class ScoreHandler;
+class ScoreBoard {
+private:
+    TextSprite scoreText{50};
+    TextSprite lengthText{50};
+
+public:
+    void refresh(const ScoreHandler& scores) { //before Draw() and outside any texture mode, rebuilds only what changed
+        scoreText.update("Score : %d", scores.getScore());
+        lengthText.update("Length : %d", scores.getLength());
+    }
+
+    void Draw() const {
+        scoreText.Draw(offset, gridHeight + 1.5 * offset, ORANGE);
+        lengthText.Draw(gridWidth - 4 * offset, gridHeight + 1.5 * offset, ORANGE);
+    }
+};
+
+class DirtyScene {
+    //persistent framebuffer for the dirty-cell render mode: the board is drawn in full once, then each tick only
+    //repaints the cells it changed (new head, vacated tail, old and new apple) and the HUD when the score moves
+    //every frame is then one blit of this texture, cutting fill and draw calls on low power GPUs such as the Pi
+    //segments snap from cell to cell in this mode, sliding would touch every segment every frame
 
 private:
-    Food* apple;
-    Snake* playerSnake; //pointer to directly access snake and food objects instantiated in GameCore class
+    RenderTexture2D scene = {0};
+    bool stale = true; //needs a full redraw, at startup, after a resize or a replay seek
 
-    CollisionHandler(Food* apple, Snake* playerSnake) : apple(apple), playerSnake(playerSnake) {}
-    //private constructor will be called as GameCore is a friend
+    std::vector<Cell> dirty; //cells touched since the last repaint, never grown past what one frame of ticks can mark
+    static constexpr int cellsPerTick = 4; //head, vacated tail, old and new apple
+    int shownScore = -1;
+    int shownLength = -1;
 
-    bool foodEaten = false;
+    void repaintCell(const Cell& cell, const SnakeSim& sim, const Snake& snake, const Food& food) const {
+        if (!sim.grid().inside(cell)) return; //a head past the border was never drawn either
 
-    void foodCollisionHandle() {
-        if (Vector2Equals(playerSnake->snakeBody[0], apple->applePos)) {
-            apple->applePos = apple->generateRandomPos(playerSnake->snakeBody);
-            playerSnake->addSegment = true;
+        Vector2 pixel = toPixel(cell);
+        Background::DrawRegion({pixel.x, pixel.y, float(cellSize), float(cellSize)});
+
+        if (sim.hasApple() && sim.apple() == cell) food.Draw(sim);
+        if (sim.grid().occupied(cell)) snake.DrawCell(cell);
+    }
 
-            foodEaten = true;
+    void redraw(const SnakeSim& sim, const Snake& snake, const Food& food, const ScoreBoard& scoreBoard) { //scoreBoard refreshed already
+        if (scene.texture.width != GetScreenWidth() || scene.texture.height != GetScreenHeight()) {
+            UnloadRenderTexture(scene);
+            scene = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
         }
+
+        BeginTextureMode(scene);
+        Background::DrawRegion({0, 0, float(scene.texture.width), float(scene.texture.height)});
+        food.Draw(sim);
+        sim.body().forEach([&](const Cell& segment) { if (sim.grid().inside(segment)) snake.DrawCell(segment); });
+        scoreBoard.Draw();
+        EndTextureMode();
+
+        shownScore = sim.scores().getScore();
+        shownLength = sim.scores().getLength();
+        dirty.clear();
+        stale = false;
     }
 
-    bool gameOver = false;
+public:
+    DirtyScene(int maxTicksPerFrame) { //the most ticks one frame can run, fast replays and catch-up included
+        dirty.reserve(maxTicksPerFrame * cellsPerTick);
+    }
 
-    void borderCollisionHandle(const Vector2& snakeHead) {
-        if (
-            snakeHead.x < offset || snakeHead.x >= gridWidth + offset || 
-            snakeHead.y < offset || snakeHead.y >= gridHeight + offset 
-        ) gameOver = true;
+    ~DirtyScene() {
+        UnloadRenderTexture(scene);
     }
 
-    void selfCollisionHandle (const Vector2& snakeHead) {
-        for (unsigned short int i = 1; i < playerSnake->snakeBody.size(); i++) { 
-            if (Vector2Equals(snakeHead, playerSnake->snakeBody[i])) {
-                gameOver = true;
-                break;
-            }
+    void invalidate() { stale = true; }
+
+    void markTick(const SnakeSim& sim, Cell oldApple, bool hadApple) { //call after every SnakeSim::step
+        if (stale) return; //the full redraw repaints everything anyway
+        if (dirty.size() + cellsPerTick > dirty.capacity()) { //more ticks than a frame should hold, cheaper to redraw than to grow
+            invalidate();
+            dirty.clear();
+            return;
         }
+
+        dirty.push_back(sim.body().front());
+        dirty.push_back(sim.lastTail()); //repainting a tail that stayed put (growth) is harmless
+        if (hadApple) dirty.push_back(oldApple);
+        if (sim.hasApple()) dirty.push_back(sim.apple());
     }
 
-    bool handle() { 
-        Vector2 snakeHead = playerSnake->snakeBody[0]; //not at class level else it wont update every update call
+    void Draw(const SnakeSim& sim, const Snake& snake, const Food& food, ScoreBoard& scoreBoard) {
+        Background::refresh();
+        scoreBoard.refresh(sim.scores()); //out here, the sprites cannot be rebuilt inside the scene's texture mode
 
-        foodCollisionHandle();
-        borderCollisionHandle(snakeHead);
-        selfCollisionHandle(snakeHead);
+        if (stale || IsWindowResized()) redraw(sim, snake, food, scoreBoard);
+        else if (!dirty.empty() || shownScore != sim.scores().getScore() || shownLength != sim.scores().getLength()) {
+            BeginTextureMode(scene);
+            for (const Cell& cell : dirty) repaintCell(cell, sim, snake, food);
+
+            if (shownScore != sim.scores().getScore() || shownLength != sim.scores().getLength()) {
+                Background::DrawRegion(Background::hudArea());
+                scoreBoard.Draw();
+                shownScore = sim.scores().getScore();
+                shownLength = sim.scores().getLength();
+            }
+            EndTextureMode();
+            dirty.clear();
+        }
 
-        return gameOver;
+        Rectangle source = {0, 0, float(scene.texture.width), -float(scene.texture.height)};
+        DrawTextureRec(scene.texture, source, {0, 0}, WHITE);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
     }
 };
 
-class ScoreHandler {
-    friend class GameCore;
+class ProfilerOverlay {
+    //F3 toggles the on-screen numbers, F4 writes profile_frames.csv and profile_trace.json next to the executable
 
 private:
-    static inline int score = 0;
-    static inline int length = 2;
+    static inline bool visible = false;
 
-    const int scoreMultiplier = 10;
+    static void line(int& y, const char* text) {
+        DrawText(text, 10, y, 20, YELLOW);
+        y += 22;
+    }
 
-    CollisionHandler* foodCollision;
+    static void timing(int& y, const char* label, Profiler::Section section) {
+        line(y, TextFormat("%-10s p50 %6.2f ms  p99 %6.2f ms", label,
+            Profiler::percentileMs(section, 0.5), Profiler::percentileMs(section, 0.99)));
+    }
 
-    void Update() {
-        if (foodCollision->foodEaten) {
-            score += scoreMultiplier;
-            length++;
+public:
+    static bool isVisible() { return visible; }
+
+    static bool Update() { //true when the overlay was toggled
+        bool toggled = IsKeyPressed(KEY_F3);
+        if (toggled) visible = !visible;
 
-            foodCollision->foodEaten = false;
+        if (IsKeyPressed(KEY_F4)) {
+            Profiler::dumpCsv("profile_frames.csv");
+            Profiler::dumpChromeTrace("profile_trace.json");
         }
-    }
 
-    void Draw() const {
-        DrawText(TextFormat("Score : %d", score), offset, gridHeight + 1.5 * offset, 50, ORANGE);
-        DrawText(TextFormat("Length : %d", length), gridWidth - 4 * offset, gridHeight + 1.5 * offset, 50, ORANGE);
+        return toggled;
     }
 
-public:
-    ScoreHandler(CollisionHandler* foodCollision) : foodCollision(foodCollision) {}
+    static void Draw() {
+        if (!visible) return;
+
+        int y = 10;
+        DrawRectangle(5, 5, 420, 8 * 22 + 10, ColorAlpha(BLACK, 0.6));
+
+        timing(y, "frame", Profiler::Frame);
+        timing(y, "tick", Profiler::Tick);
+        timing(y, "draw snake", Profiler::DrawSnake);
+        timing(y, "draw hud", Profiler::DrawHud);
+        timing(y, "end draw", Profiler::EndDrawing);
+
+        line(y, TextFormat("draw calls      %d", Profiler::lastCounter(Profiler::DrawCalls)));
+        line(y, TextFormat("ticks/frame     %d", Profiler::lastCounter(Profiler::Ticks)));
+        line(y, TextFormat("spawn samples   %d", Profiler::lastCounter(Profiler::SpawnSamples)));
+    }
 };
 
 class GameCore {
 private:
-    GameSettings::Difficulty difficulty;
-    Snake playerSnake; //initialize first as apple.generateRandomPos() needs snake reference
+    uint64_t seed;
+    const ReplayReader* replay; //set when playing a recording back, input then comes from it instead of the keyboard
+    SnakeSim sim;
+    Snake playerSnake;
     Food apple;
-    CollisionHandler collision;
-    ScoreHandler scoreBoard;
+    ScoreBoard scoreBoard;
 
     bool gameOver = false;
 
-    void gameOverDraw() const {
-        if (gameOver) {
+    static constexpr int maxTicksPerFrame = 8; //after a long stall drop the backlog instead of fast-forwarding the game
+    static constexpr double maxReplaySpeed = 64; //fast replays owe up to this many times maxTicksPerFrame per frame
+    double accumulator = 0; //simulation time owed to the scheduler, always less than one interval after Update()
+    double lastFrameTime = 0;
+
+    std::unique_ptr<ReplayWriter> recorder; //every tick's input goes to disk when recording
+
+    bool dirtyRendering; //persistent framebuffer, only changed cells are redrawn
+    DirtyScene scene{int(maxTicksPerFrame * maxReplaySpeed)};
+
+    int replayTick = 0; //next input to apply from the replay
+    double replaySpeed = 1;
+    static constexpr int replaySeekTicks = 50; //left / right arrow jump
+
+    std::unique_ptr<Autopilot> autopilot; //set with --autopilot, plans every tick's input in place of the keyboard
+
+    std::unique_ptr<NetClient> net; //set with --connect, the server then owns the game and sets the pace
+    std::unique_ptr<PredictedGame> online; //made once the server welcomes us; sim is a copy of its predicted state
+    double lastHello = -1;
+
+    std::unique_ptr<StatsStore> stats; //set with --stats, every finished offline game lands on the leaderboard
+    int ticksPlayed = 0;
+
+    TextSprite winText{80};
+    TextSprite overText{80};
+    TextSprite bestText{40};
+
+    void gameOverDraw() { //outside any texture mode, the sprites are built on first use
+        if (sim.collisions().isBoardFull()) {
+            winText.update("YOU WIN!");
+            winText.Draw(offset + (gridWidth - winText.width()) / 2, (gridHeight / 2), GOLD);
+        }
+        else if (gameOver) {
             unsigned char alpha = ((sinf(GetTime() * 3) + 1) * 0.5) * 255;
             //sin(x) + 1 -> range shifts from -1 -> 1 to 0 -> 2 (mx + c), * 0.5 -> makes range 0 to 1, GetTime() * 4 is speed, * 255 for alpha
             Color FlashingRed = {255, 0, 0, alpha};
-            DrawText("GAME OVER!", (gridWidth / 2) - 4 * cellSize, (gridHeight / 2) , 80, FlashingRed);
+            overText.update("GAME OVER!");
+            overText.Draw(offset + (gridWidth - overText.width()) / 2, (gridHeight / 2), FlashingRed); //the flash is only the tint
+        }
+
+        if (stats && gameOver) { //already includes this game, record() updates the table before the writer catches up
+            bestText.update("BEST %d", stats->table().best(int(playerSnake.difficulty)));
+            bestText.Draw(offset + (gridWidth - bestText.width()) / 2, gridHeight / 2 + 90, GOLD);
         }
     }
 
-    void Update() {
-        if (!gameOver) {
-            playerSnake.Update(); //stopping this also stops random apple pos generation
-            scoreBoard.Update();
-            gameOver = collision.handle();
+    void tick() {
+        SNAKE_PROFILE_SCOPE(Tick);
+        SNAKE_PROFILE_COUNT(Ticks, 1);
+
+        Cell oldApple = sim.apple();
+        bool hadApple = sim.hasApple();
+
+        Direction input;
+        if (replay) input = replay->input(replayTick++);
+        else if (autopilot) input = autopilot->next(sim);
+        else input = playerSnake.nextTurn(sim.heading());
+        if (online) { //predicted at once, the server confirms or corrects it a round trip later
+            online->advance(input);
+            sim = online->predicted(); //copy-assigned into the same buffers, no allocation
+            gameOver = sim.isOver();
+        }
+        else gameOver = sim.step(input); //stopping this also stops random apple pos generation
+
+        if (dirtyRendering) scene.markTick(sim, oldApple, hadApple);
+        if (replay) return;
+
+        ticksPlayed++;
+        if (gameOver && stats) stats->record(GameRecord::of(sim, seed, ticksPlayed, int(playerSnake.difficulty))); //queued, no disk I/O here
+
+        if (recorder) {
+            recorder->record(input, sim);
+            if (gameOver) recorder->finish(sim);
         }
     }
 
-    void Draw() const {
-        Background::Draw();
-        apple.Draw();
-        playerSnake.Draw();
-        scoreBoard.Draw();
+    bool canTick() const { //a replay cut short just stops on its last recorded tick
+        if (net && !(online && online->canPredict())) return false; //still joining, or too far ahead of the server
+        return !gameOver && (!replay || replayTick < replay->ticks());
+    }
+
+    double tickInterval() const {
+        if (online) return 1.0 / net->ticksPerSecond();
+        return playerSnake.interval / replaySpeed;
+    }
+
+    bool netSync() { //before ticking: join, then fold the server's ticks in; true when the shown state changed
+        if (!online) {
+            net->poll();
+            if (!net->joined()) {
+                if (GetTime() - lastHello > PredictedGame::keepAlive) {
+                    net->send();
+                    lastHello = GetTime();
+                }
+                return false;
+            }
+
+            online = std::make_unique<PredictedGame>(*net);
+            sim = online->predicted();
+            accumulator = (1 + PredictedGame::leadTicks) * tickInterval(); //start a little ahead so inputs arrive in time
+            scene.invalidate();
+            return true;
+        }
+
+        if (!online->reconcile()) return false;
+        sim = online->predicted(); //rolled back and re-simulated, possibly undoing a predicted death
+        gameOver = sim.isOver();
+        scene.invalidate();
+        return true;
+    }
 
-        gameOverDraw();
+    void netDraw() const {
+        if (!net) return;
+        const char* status = online ? TextFormat("ONLINE  ahead %d  rollbacks %d", online->ahead(), online->rollbacks()) : "CONNECTING...";
+        DrawText(status, offset, 10, 30, online ? SKYBLUE : ORANGE);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
+    }
+
+    void seek(int tick) {
+        replayTick = std::clamp(tick, 0, replay->ticks());
+        sim = replay->stateAt(replayTick); //nearest keyframe, then at most one keyframe interval of steps
+        gameOver = sim.isOver();
+        accumulator = 0;
+        scene.invalidate();
+    }
+
+    bool replayControls() { //arrows seek and change speed, only while playing a recording back; true when anything changed
+        if (IsKeyPressed(KEY_RIGHT)) seek(replayTick + replaySeekTicks);
+        if (IsKeyPressed(KEY_LEFT)) seek(replayTick - replaySeekTicks);
+        if (IsKeyPressed(KEY_UP)) replaySpeed = std::min(replaySpeed * 2, maxReplaySpeed);
+        if (IsKeyPressed(KEY_DOWN)) replaySpeed = std::max(replaySpeed / 2, 0.125);
+
+        return IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_UP) || IsKeyPressed(KEY_DOWN);
+    }
+
+    void replayDraw() const {
+        if (!replay) return;
+        DrawText(TextFormat("REPLAY x%g  tick %d / %d", replaySpeed, replayTick, replay->ticks()), offset, 10, 30, ORANGE);
+        SNAKE_PROFILE_COUNT(DrawCalls, 1);
+    }
+
+    bool Update() { //true when anything on screen changed
+        double currentTime = GetTime();
+        accumulator += currentTime - lastFrameTime;
+        lastFrameTime = currentTime;
+
+        bool changed = ProfilerOverlay::Update();
+        if (AssetCache::poll()) { //swap placeholders for textures that finished loading
+            changed = true;
+            scene.invalidate();
+        }
+        if (replay) changed |= replayControls();
+        if (net) changed |= netSync();
+
+        if (!canTick()) {
+            if (online) online->flush(currentTime, false);
+            return changed;
+        }
+
+        if (!replay && !autopilot) {
+            SNAKE_PROFILE_SCOPE(Input);
+            playerSnake.Update(sim.heading());
+        }
+
+        double interval = tickInterval();
+        int tickLimit = std::max(maxTicksPerFrame, int(maxTicksPerFrame * replaySpeed)); //fast replays owe more ticks per frame
+
+        int ticks = 0;
+        while (accumulator >= interval && canTick()) { //fixed step, as many ticks as the elapsed time owes
+            tick();
+            accumulator -= interval;
+
+            if (++ticks == tickLimit) {
+                accumulator = std::min(accumulator, interval);
+                break;
+            }
+        }
+
+        if (online) online->flush(currentTime, ticks > 0);
+        return changed || ticks > 0;
+    }
+
+    bool animating() const { //every drawn frame would differ from the last
+        return ProfilerOverlay::isVisible() || (!dirtyRendering && canTick()); //interpolated sliding
+    }
+
+    double untilNextTick() const {
+        return canTick() ? tickInterval() - accumulator : 1.0;
+    }
+
+    float interpolation() const {
+        if (!canTick()) return 1; //freeze on the final tick
+        return std::min(accumulator / tickInterval(), 1.0);
+    }
+
+    void Draw() {
+        if (dirtyRendering) {
+            {
+                SNAKE_PROFILE_SCOPE(DrawSnake);
+                scene.Draw(sim, playerSnake, apple, scoreBoard);
+            }
+            {
+                SNAKE_PROFILE_SCOPE(DrawHud);
+                gameOverDraw();
+                replayDraw();
+                netDraw();
+            }
+
+            ProfilerOverlay::Draw();
+            return;
+        }
+
+        {
+            SNAKE_PROFILE_SCOPE(DrawBackground);
+            Background::Draw();
+        }
+        {
+            SNAKE_PROFILE_SCOPE(DrawFood);
+            apple.Draw(sim);
+        }
+        {
+            SNAKE_PROFILE_SCOPE(DrawSnake);
+            playerSnake.Draw(sim, interpolation());
+        }
+        {
+            SNAKE_PROFILE_SCOPE(DrawHud);
+            scoreBoard.refresh(sim.scores());
+            scoreBoard.Draw();
+            gameOverDraw();
+            replayDraw();
+            netDraw();
+        }
+
+        ProfilerOverlay::Draw();
     }
 
 public:
-    GameCore(std::string sDifficulty) :
-        playerSnake(GameSettings::setDifficulty(sDifficulty)), 
-        apple(playerSnake.snakeBody),
-        collision(&apple, &playerSnake),
-        scoreBoard(&collision)
-    {}
+    GameCore(std::string sDifficulty, const char* recordPath = nullptr, const ReplayReader* replay = nullptr, bool dirtyRendering = false,
+        const char* connectAddress = nullptr, const char* autopilotMode = nullptr, const char* statsPath = nullptr) :
+        seed(replay ? replay->seed() : GetRandomValue(0, INT32_MAX)), //raylib seeds its generator from the clock at InitWindow
+        replay(replay),
+        sim(seed, board),
+        playerSnake(GameSettings::setDifficulty(sDifficulty)),
+        dirtyRendering(dirtyRendering)
+    {
+        if (autopilotMode && !replay) autopilot = std::make_unique<Autopilot>(Autopilot::parse(autopilotMode));
+
+        if (connectAddress) {
+            net = std::make_unique<NetClient>();
+            if (!net->connect(connectAddress, board)) {
+                TraceLog(LOG_WARNING, "NET: cannot reach %s with a %dx%d board, playing offline", connectAddress, board.rows, board.cols);
+                net.reset();
+            }
+        }
+
+        if (recordPath && !replay && !net) { //online the server decides what happened, a local recording could disagree
+            recorder = std::make_unique<ReplayWriter>(recordPath, seed, board);
+            if (!recorder->good()) {
+                TraceLog(LOG_WARNING, "REPLAY: cannot write %s, not recording", recordPath);
+                recorder.reset();
+            }
+        }
+
+        if (statsPath && !replay && !net) { //online results belong to the server
+            stats = std::make_unique<StatsStore>(statsPath);
+            if (!stats->good()) TraceLog(LOG_WARNING, "STATS: cannot use %s, scores this session are not saved", statsPath);
+        }
+
+        Background::load();
+    }
 
     void exec() {
-        while (!WindowShouldClose()) {
-            BeginDrawing();
+        lastFrameTime = GetTime();
 
-            Update();
-            Draw();
+        while (!WindowShouldClose()) {
+            bool drawn;
+            {
+                SNAKE_PROFILE_SCOPE(Frame);
+                bool changed = Update();
+
+                drawn = FramePacer::shouldDraw(changed, animating(), gameOver && !sim.collisions().isBoardFull());
+                if (drawn) {
+                    BeginDrawing();
+                    Draw();
+
+                    SNAKE_PROFILE_SCOPE(EndDrawing);
+                    EndDrawing();
+                }
+            }
 
-            EndDrawing();
+            if (drawn) Profiler::endFrame(); //skipped loops fold into the next drawn frame's numbers
+            else FramePacer::idle(untilNextTick());
         }
 
+        Background::unload();
+        AssetCache::clear();
         CloseWindow();
     }
 };
 
-int main() {
-    GameSettings::gameInit();
+int main(int argc, char** argv) {
+    //Snake [--difficulty Easy|Medium|Hard] [--board RxC] [--record file.snkr | --replay file.snkr] [--render full|dirty]
+    //      [--pacing adaptive|fixed|vsync] [--connect host:port] [--autopilot path|cycle] [--stats file.snks]
+    std::string difficulty = "Medium";
+    BoardSize boardSize = defaultBoard;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* connectAddress = nullptr;
+    const char* autopilotMode = nullptr;
+    const char* statsPath = nullptr;
+    bool dirtyRendering = false;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--difficulty") difficulty = argv[i + 1];
+        else if (option == "--board") sscanf(argv[i + 1], "%dx%d", &boardSize.rows, &boardSize.cols);
+        else if (option == "--record") recordPath = argv[i + 1];
+        else if (option == "--replay") replayPath = argv[i + 1];
+        else if (option == "--render") dirtyRendering = std::string(argv[i + 1]) == "dirty";
+        else if (option == "--pacing") FramePacer::setMode(FramePacer::parse(argv[i + 1]));
+        else if (option == "--connect") connectAddress = argv[i + 1];
+        else if (option == "--autopilot") autopilotMode = argv[i + 1];
+        else if (option == "--stats") statsPath = argv[i + 1];
+    }
+
+    if (!boardSize.valid()) boardSize = defaultBoard;
+
+    std::vector<uint8_t> replayBytes; //outlives the game, the reader points into it
+    std::unique_ptr<ReplayReader> replay;
+    if (replayPath) {
+        if (!ReplayReader::loadFile(replayPath, replayBytes)) {
+            fprintf(stderr, "cannot read %s\n", replayPath);
+            return 1;
+        }
+
+        replay = std::make_unique<ReplayReader>(replayBytes.data(), replayBytes.size());
+        if (!replay->valid()) {
+            fprintf(stderr, "%s: %s\n", replayPath, replay->error());
+            return 1;
+        }
+        boardSize = replay->boardSize(); //the recording decides the board
+    }
+
+    GameSettings::gameInit(boardSize);
 
-    GameCore game("Medium");
+    GameCore game(difficulty, recordPath, replay.get(), dirtyRendering, replay ? nullptr : connectAddress, autopilotMode, statsPath);
         
     game.exec();
 
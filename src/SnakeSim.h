@@ -0,0 +1,649 @@
+#pragma once
+
+//headless game core, plain C++ only so it can run without a window or GPU
+//input and randomness are injected, the raylib front-end in Snake.cpp just draws this state
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <initializer_list>
+
+#include "Profiler.h"
+
+struct BoardSize {
+    //picked at runtime, common power-of-two squares still get a step kernel specialised at compile time
+    int rows = 16;
+    int cols = 16;
+
+    static constexpr int minSide = 4; //the start body sits two cells left of the middle
+    static constexpr int maxSide = 4096; //cells must fit int16_t and the grid stays within a few hundred MB
+
+    int cells() const { return rows * cols; }
+    bool valid() const { return rows >= minSide && cols >= minSide && rows <= maxSide && cols <= maxSide; }
+    bool operator==(const BoardSize& other) const = default;
+};
+
+constexpr BoardSize defaultBoard = {16, 16};
+
+struct Cell {
+    //game state lives in whole cells, pixels only exist inside the Draw() paths
+    int16_t x;
+    int16_t y;
+
+    bool operator==(const Cell& other) const = default; //exact integer compare, no float epsilon needed
+
+    Cell operator+(const Cell& other) const {
+        return {int16_t(x + other.x), int16_t(y + other.y)};
+    }
+};
+
+enum class Direction : uint8_t {Up, Down, Left, Right}; //fits in 2 bits
+
+inline Cell toStep(Direction direction) {
+    switch(direction) {
+        case Direction::Up : return {0, -1};
+        case Direction::Down : return {0, 1};
+        case Direction::Left : return {-1, 0};
+        case Direction::Right : return {1, 0};
+    }
+    return {0, 0};
+}
+
+inline bool isOpposite(Direction a, Direction b) {
+    return toStep(a) + toStep(b) == Cell{0, 0};
+}
+
+class TurnQueue {
+    //turns pressed between ticks, applied one per tick so two quick presses both land instead of the last one winning
+    //each turn is checked against the one queued before it, so Up then Left while heading Right can never reverse into the neck
+
+private:
+    static constexpr int capacity = 3; //more than this is mashing, further presses are dropped until a tick frees a slot
+
+    Direction turns[capacity] = {};
+    int first = 0;
+    int count = 0;
+
+public:
+    bool push(Direction turn, Direction heading) { //heading is the direction the snake moves on its current tick
+        Direction last = count ? turns[(first + count - 1) % capacity] : heading;
+        if (turn == last || isOpposite(turn, last) || count == capacity) return false;
+
+        turns[(first + count) % capacity] = turn;
+        count++;
+        return true;
+    }
+
+    Direction next(Direction heading) { //one per tick, keeps the current heading when nothing was pressed
+        if (count == 0) return heading;
+
+        Direction turn = turns[first];
+        first = (first + 1) % capacity;
+        count--;
+        return turn;
+    }
+
+    void clear() { count = 0; }
+    int size() const { return count; }
+};
+
+class Rng {
+    //pcg32, small POD state so every game carries its own reproducible stream
+    friend class StateCodec;
+    friend class SnakeSim;
+
+private:
+    uint64_t state = 0;
+    static constexpr uint64_t increment = 1442695040888963407ull;
+
+public:
+    Rng(uint64_t seed = 0) {
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + increment;
+
+        uint32_t xorShifted = ((old >> 18) ^ old) >> 27;
+        uint32_t rot = old >> 59;
+        return (xorShifted >> rot) | (xorShifted << ((-rot) & 31));
+    }
+
+    int range(int min, int max) { //both inclusive, same contract as raylib GetRandomValue
+        uint32_t span = max - min + 1;
+        return min + int((uint64_t(next()) * span) >> 32);
+    }
+};
+
+class SnakeBody {
+    //fixed capacity ring buffer, one contiguous block sized for a full board and never resized after startup
+    //index 0 is the head, size() - 1 the tail
+
+private:
+    std::vector<Cell> cells;
+    int headSlot = 0;
+    int length = 0;
+
+    int slot(int i) const {
+        int s = headSlot + i;
+        return s < capacity() ? s : s - capacity(); //cheaper than % on the hot path
+    }
+
+public:
+    SnakeBody(int capacity) : cells(capacity) {}
+
+    SnakeBody(int capacity, std::initializer_list<Cell> segments) : cells(capacity) {
+        for (const Cell& segment : segments) push_back(segment);
+    }
+
+    int capacity() const { return cells.size(); }
+    int size() const { return length; }
+
+    const Cell& operator[](int i) const { return cells[slot(i)]; }
+    const Cell& front() const { return cells[headSlot]; }
+    const Cell& back() const { return cells[slot(length - 1)]; }
+
+    void push_front(const Cell& cell) {
+        headSlot = headSlot == 0 ? capacity() - 1 : headSlot - 1;
+        cells[headSlot] = cell;
+        length++;
+    }
+
+    void push_back(const Cell& cell) {
+        cells[slot(length)] = cell;
+        length++;
+    }
+
+    void pop_back() { length--; }
+
+    void copyTo(Cell* out) const { //head to tail, the same two runs as forEach but as memcpy
+        int firstRun = std::min(length, capacity() - headSlot);
+        memcpy(out, cells.data() + headSlot, firstRun * sizeof(Cell));
+        memcpy(out + firstRun, cells.data(), (length - firstRun) * sizeof(Cell));
+    }
+
+    void assign(const Cell* segments, int count) { //head to tail, count <= capacity()
+        memcpy(cells.data(), segments, count * sizeof(Cell));
+        headSlot = 0;
+        length = count;
+    }
+
+    template <typename Func>
+    void forEach(Func func) const { //head to tail in at most two linear runs over the buffer
+        int firstRun = std::min(length, capacity() - headSlot);
+
+        for (int i = headSlot; i < headSlot + firstRun; i++) func(cells[i]);
+        for (int i = 0; i < length - firstRun; i++) func(cells[i]);
+    }
+};
+
+class OccupancyGrid {
+    //single source of truth for which cells the snake covers, queried by the food spawn and CollisionHandler
+    //counts instead of bits so a head moving onto its own body reads 2 and is caught in O(1)
+    friend class StateCodec;
+
+private:
+    int gridRows;
+    int gridCols;
+    std::vector<uint8_t> cells;
+
+    std::vector<int> freeCells; //every empty cell index, packed at the front so a spawn is one random pick
+    std::vector<int> freeSlot; //cell index -> its position in freeCells, -1 while occupied
+
+    int index(const Cell& pos) const {
+        return pos.y * gridCols + pos.x;
+    }
+
+    void removeFree(int cell) { //swap-remove keeps the free list dense in O(1)
+        int slot = freeSlot[cell];
+        int last = freeCells.back();
+
+        freeCells[slot] = last;
+        freeSlot[last] = slot;
+
+        freeCells.pop_back();
+        freeSlot[cell] = -1;
+    }
+
+    void addFree(int cell) {
+        freeSlot[cell] = freeCells.size();
+        freeCells.push_back(cell); //never reallocates, capacity reserved for the whole board
+    }
+
+public:
+    OccupancyGrid(int gridRows, int gridCols) :
+        gridRows(gridRows), gridCols(gridCols),
+        cells(gridRows * gridCols, 0), freeSlot(gridRows * gridCols)
+    {
+        freeCells.reserve(gridRows * gridCols);
+        clear();
+    }
+
+    void clear() { //empty board with the free list in index order, as constructed, without reallocating
+        std::fill(cells.begin(), cells.end(), 0);
+        freeCells.clear();
+        for (int cell = 0; cell < gridRows * gridCols; cell++) addFree(cell);
+    }
+
+    int rowCount() const { return gridRows; }
+    int colCount() const { return gridCols; }
+
+    bool inside(const Cell& pos) const {
+        return pos.x >= 0 && pos.x < gridCols && pos.y >= 0 && pos.y < gridRows;
+    }
+
+    //raw cell index versions, the specialised step kernels compute the index themselves
+    void occupyIndex(int cell) { if (cells[cell]++ == 0) removeFree(cell); }
+    void releaseIndex(int cell) { if (--cells[cell] == 0) addFree(cell); }
+    unsigned int countIndex(int cell) const { return cells[cell]; }
+
+    void occupy(const Cell& pos) {
+        if (inside(pos)) occupyIndex(index(pos)); //head past the border is never stored, border check catches it
+    }
+
+    void release(const Cell& pos) {
+        if (inside(pos)) releaseIndex(index(pos));
+    }
+
+    unsigned int count(const Cell& pos) const {
+        return inside(pos) ? cells[index(pos)] : 0;
+    }
+
+    bool occupied(const Cell& pos) const { return count(pos) > 0; }
+
+    int freeCount() const { return freeCells.size(); }
+    int freeCellIndex(int slot) const { return freeCells[slot]; } //slot in [0, freeCount())
+    const int* freeList() const { return freeCells.data(); }
+    const int* freeSlots() const { return freeSlot.data(); } //one per cell
+    const uint8_t* counts() const { return cells.data(); } //one byte per cell, row major, what CollisionHandler reads
+
+    Cell freeCellPos(int slot) const {
+        int cell = freeCells[slot];
+        return {int16_t(cell % gridCols), int16_t(cell / gridCols)};
+    }
+
+    void rebuild(const SnakeBody& body, const int* freeList, int freeListCount, const int* slots) { //counts from the body, the rest as given
+        std::fill(cells.begin(), cells.end(), 0);
+        body.forEach([&](const Cell& segment) { if (inside(segment)) cells[index(segment)]++; });
+
+        freeCells.assign(freeList, freeList + freeListCount); //within the reserved capacity, never reallocates
+        memcpy(freeSlot.data(), slots, freeSlot.size() * sizeof(int));
+    }
+};
+
+struct DynamicShape {
+    //any board size, index math is a multiply
+    int rows;
+    int cols;
+
+    int index(const Cell& cell) const { return cell.y * cols + cell.x; }
+    Cell cellAt(int index) const { return {int16_t(index % cols), int16_t(index / cols)}; }
+
+    bool inside(const Cell& cell) const { //unsigned compare folds the < 0 check in
+        return unsigned(cell.x) < unsigned(cols) && unsigned(cell.y) < unsigned(rows);
+    }
+};
+
+template <int Rows, int Cols>
+struct FixedShape {
+    //board size known at compile time; for powers of two the index math becomes shifts and masks
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+
+    static constexpr int index(const Cell& cell) { return cell.y * Cols + cell.x; }
+    static constexpr Cell cellAt(int index) { return {int16_t(index % Cols), int16_t(index / Cols)}; }
+
+    static constexpr bool inside(const Cell& cell) {
+        return unsigned(cell.x) < unsigned(Cols) && unsigned(cell.y) < unsigned(Rows);
+    }
+};
+
+struct StartingSegments { //every game starts from the same two segments near the middle, heading left
+    Cell cells[2];
+};
+
+inline StartingSegments startingSegments(BoardSize board) {
+    return {{
+        Cell{int16_t(board.cols / 2 - 2), int16_t(board.rows / 2 - 2)},
+        Cell{int16_t(board.cols / 2 - 1), int16_t(board.rows / 2 - 2)}
+    }};
+}
+
+inline void resetStart(SnakeBody& body, OccupancyGrid& grid, BoardSize board) { //back to the start in the buffers already there
+    StartingSegments start = startingSegments(board);
+    body.assign(start.cells, 2);
+    grid.clear();
+    for (const Cell& segment : start.cells) grid.occupy(segment);
+}
+
+inline SnakeBody startingBody(BoardSize board) {
+    StartingSegments start = startingSegments(board);
+    return {board.cells(), {start.cells[0], start.cells[1]}}; //O(1) push/pop and no allocation once the game starts
+}
+
+inline OccupancyGrid makeOccupancy(const SnakeBody& snakeBody, BoardSize board) {
+    OccupancyGrid grid(board.rows, board.cols);
+    snakeBody.forEach([&](const Cell& segment) { grid.occupy(segment); });
+    return grid;
+}
+
+class SnakeSim;
+
+template <int MaxCells>
+struct SimSnapshot {
+    //every field SnakeSim::step reads, flat and trivially copyable: save / restore are a few memcpys, never the heap
+    //fits any board up to MaxCells; only the used part of the arrays is written, so small boards stay cheap in big snapshots
+    uint64_t rngState;
+    BoardSize board;
+    int32_t score;
+    int32_t length;
+    Cell apple;
+    Cell prevTail;
+    uint8_t direction;
+    uint8_t flags; //addSegment | appleSpawned | hasMoved | boardFull | gameOver, as in StateCodec
+    int32_t bodyLength;
+    int32_t freeCount;
+
+    Cell body[MaxCells]; //head to tail
+    int32_t freeCells[MaxCells]; //free list order, the next apple spawn depends on it
+    int32_t freeSlot[MaxCells]; //its inverse, stored since rebuilding it is a scatter over the whole board
+
+    static constexpr int maxCells = MaxCells;
+};
+
+class CollisionHandler {
+    friend class SnakeSim;
+    friend class ScoreHandler;
+    friend class StateCodec;
+
+private:
+    bool foodEaten = false;
+    bool boardFull = false; //win, no free cell left for the next apple
+    bool gameOver = false;
+
+    template <typename Shape> void foodCollisionHandle(SnakeSim& sim, const Shape& shape);
+    template <typename Shape> void borderCollisionHandle(const Shape& shape, const Cell& snakeHead);
+    template <typename Shape> void selfCollisionHandle(const SnakeSim& sim, const Shape& shape, const Cell& snakeHead);
+
+    template <typename Shape> bool handle(SnakeSim& sim, const Shape& shape);
+
+public:
+    bool isGameOver() const { return gameOver; }
+    bool isBoardFull() const { return boardFull; }
+};
+
+class ScoreHandler {
+    friend class SnakeSim;
+    friend class StateCodec;
+
+private:
+    int score = 0; //per game, so any number of sims can run side by side
+    int length = 2;
+
+    static constexpr int scoreMultiplier = 10;
+
+    void Update(CollisionHandler& foodCollision) {
+        if (foodCollision.foodEaten) {
+            score += scoreMultiplier;
+            if (!foodCollision.boardFull) length++; //the winning apple scores but has no cell left to grow into
+
+            foodCollision.foodEaten = false;
+        }
+    }
+
+public:
+    int getScore() const { return score; }
+    int getLength() const { return length; }
+};
+
+class SnakeSim {
+    //one game, advanced a whole tick at a time by step()
+    friend class CollisionHandler;
+    friend class StateCodec;
+
+public:
+    enum class Kernel : uint8_t {Generic, Board16, Board32, Board64, Board128, Board256};
+
+private:
+    BoardSize board;
+    Kernel kernel;
+
+    SnakeBody snakeBody;
+    OccupancyGrid occupancy; //declared after snakeBody so it is built from the initial segments
+
+    Rng rng;
+
+    Direction direction = Direction::Left;
+    bool addSegment = false;
+
+    Cell applePos = {0, 0};
+    bool appleSpawned = false; //false once the board is full and no apple is left
+
+    Cell prevTail = {0, 0}; //where the tail was before the last tick, kept for render interpolation
+    bool hasMoved = false;
+
+    CollisionHandler collision;
+    ScoreHandler scoreBoard;
+
+    static Kernel pickKernel(BoardSize board) {
+        if (board.rows != board.cols) return Kernel::Generic;
+
+        switch (board.rows) {
+            case 16 : return Kernel::Board16;
+            case 32 : return Kernel::Board32;
+            case 64 : return Kernel::Board64;
+            case 128 : return Kernel::Board128;
+            case 256 : return Kernel::Board256;
+            default : return Kernel::Generic;
+        }
+    }
+
+    template <typename Shape>
+    std::optional<Cell> generateRandomPos(const Shape& shape) {
+        SNAKE_PROFILE_SCOPE(FoodSpawn);
+        SNAKE_PROFILE_COUNT(SpawnSamples, 1); //always one sample now that spawns draw from the free list
+
+        if (occupancy.freeCount() == 0) return std::nullopt; //snake covers the whole board, nowhere left to spawn
+
+        return shape.cellAt(occupancy.freeCellIndex(rng.range(0, occupancy.freeCount() - 1))); //always lands on an empty cell
+    }
+
+    template <typename Shape>
+    bool respawnApple(const Shape& shape) {
+        std::optional<Cell> pos = generateRandomPos(shape);
+        appleSpawned = pos.has_value();
+        if (appleSpawned) applePos = *pos;
+
+        return appleSpawned;
+    }
+
+    template <typename Shape>
+    void moveSnake(const Shape& shape, const Cell& step) {
+        Cell newHead = snakeBody.front() + step;
+        prevTail = snakeBody.back(); //a grown tail stays put, so it slides from itself
+
+        if (addSegment) addSegment = false;
+        else {
+            occupancy.releaseIndex(shape.index(snakeBody.back())); //the tail is always on the board
+            snakeBody.pop_back();
+        }
+        //when addSegment is true we just dont pop back for that tick, adding a segment
+        //tail leaves before the head enters so a full board never needs a spare slot
+
+        snakeBody.push_front(newHead);
+        if (shape.inside(newHead)) occupancy.occupyIndex(shape.index(newHead)); //off-board heads are left to the border check
+        hasMoved = true;
+    }
+
+    template <typename Shape>
+    bool stepWith(const Shape& shape) {
+        moveSnake(shape, toStep(direction));
+        collision.handle(*this, shape);
+        scoreBoard.Update(collision);
+
+        return isOver();
+    }
+
+public:
+    SnakeSim(uint64_t seed, BoardSize board = defaultBoard) : 
+        board(board), kernel(pickKernel(board)), 
+        snakeBody(startingBody(board)), occupancy(makeOccupancy(snakeBody, board)), 
+        rng(seed)
+    {
+        respawnApple(DynamicShape{board.rows, board.cols});
+    }
+
+    void reset(uint64_t seed) { //the game SnakeSim(seed, boardSize()) would start, in the body and grid already allocated
+        resetStart(snakeBody, occupancy, board);
+        rng = Rng(seed);
+
+        direction = Direction::Left;
+        addSegment = false;
+        applePos = {0, 0};
+        appleSpawned = false;
+        prevTail = {0, 0};
+        hasMoved = false;
+        collision = CollisionHandler();
+        scoreBoard = ScoreHandler();
+
+        respawnApple(DynamicShape{board.rows, board.cols});
+    }
+
+    bool step(Direction input) { //one simulation tick, returns true once the game has ended
+        if (isOver()) return true;
+
+        if (!isOpposite(input, direction)) direction = input; //reversing into the neck is ignored, keep heading
+
+        switch (kernel) { //same branch every tick, so it predicts perfectly
+            case Kernel::Board16 : return stepWith(FixedShape<16, 16>());
+            case Kernel::Board32 : return stepWith(FixedShape<32, 32>());
+            case Kernel::Board64 : return stepWith(FixedShape<64, 64>());
+            case Kernel::Board128 : return stepWith(FixedShape<128, 128>());
+            case Kernel::Board256 : return stepWith(FixedShape<256, 256>());
+            default : return stepWith(DynamicShape{board.rows, board.cols});
+        }
+    }
+
+    void useGenericKernel() { kernel = Kernel::Generic; } //for benchmarks comparing against the runtime-sized path
+    void reseed(uint64_t seed) { rng = Rng(seed); } //new apple stream from here on, lets a search treat spawns as chance
+    Kernel stepKernel() const { return kernel; }
+
+    BoardSize boardSize() const { return board; }
+
+    bool isOver() const { return collision.gameOver || collision.boardFull; }
+
+    const SnakeBody& body() const { return snakeBody; }
+    const OccupancyGrid& grid() const { return occupancy; }
+    const CollisionHandler& collisions() const { return collision; }
+    const ScoreHandler& scores() const { return scoreBoard; }
+
+    Direction heading() const { return direction; }
+    bool growing() const { return addSegment; } //an apple was eaten, the tail stays put next tick
+    bool hasApple() const { return appleSpawned; }
+    Cell apple() const { return applePos; }
+
+    bool started() const { return hasMoved; }
+    Cell lastTail() const { return prevTail; }
+
+    template <int MaxCells>
+    bool save(SimSnapshot<MaxCells>& out) const { //false when the board is bigger than the snapshot
+        static_assert(std::is_trivially_copyable_v<SimSnapshot<MaxCells>> && sizeof(int) == sizeof(int32_t));
+        if (board.cells() > MaxCells) return false;
+
+        out.rngState = rng.state;
+        out.board = board;
+        out.score = scoreBoard.score;
+        out.length = scoreBoard.length;
+        out.apple = applePos;
+        out.prevTail = prevTail;
+        out.direction = uint8_t(direction);
+        out.flags = addSegment | appleSpawned << 1 | hasMoved << 2 | collision.boardFull << 3 | collision.gameOver << 4;
+
+        out.bodyLength = snakeBody.size();
+        snakeBody.copyTo(out.body);
+        out.freeCount = occupancy.freeCount();
+        memcpy(out.freeCells, occupancy.freeList(), out.freeCount * sizeof(int32_t));
+        memcpy(out.freeSlot, occupancy.freeSlots(), board.cells() * sizeof(int32_t));
+        return true;
+    }
+
+    template <int MaxCells>
+    bool restore(const SimSnapshot<MaxCells>& in) { //false unless it was saved from a sim on the same board
+        if (in.board.rows != board.rows || in.board.cols != board.cols) return false;
+
+        rng.state = in.rngState;
+        scoreBoard.score = in.score;
+        scoreBoard.length = in.length;
+        applePos = in.apple;
+        prevTail = in.prevTail;
+        direction = Direction(in.direction);
+        addSegment = in.flags & 1;
+        appleSpawned = in.flags & 2;
+        hasMoved = in.flags & 4;
+        collision.boardFull = in.flags & 8;
+        collision.gameOver = in.flags & 16;
+        collision.foodEaten = false; //always consumed within the tick that set it
+
+        snakeBody.assign(in.body, in.bodyLength);
+        occupancy.rebuild(snakeBody, in.freeCells, in.freeCount, in.freeSlot);
+        return true;
+    }
+};
+
+template <typename Shape>
+void CollisionHandler::foodCollisionHandle(SnakeSim& sim, const Shape& shape) {
+    if (sim.appleSpawned && sim.snakeBody.front() == sim.applePos) {
+        if (sim.respawnApple(shape)) sim.addSegment = true;
+        else boardFull = true; //the body already covers every cell, nothing left to grow
+
+        foodEaten = true;
+    }
+}
+
+template <typename Shape>
+void CollisionHandler::borderCollisionHandle(const Shape& shape, const Cell& snakeHead) {
+    if (!shape.inside(snakeHead)) gameOver = true;
+}
+
+template <typename Shape>
+void CollisionHandler::selfCollisionHandle(const SnakeSim& sim, const Shape& shape, const Cell& snakeHead) {
+    if (gameOver) return; //off the board, there is no cell to look up
+    if (sim.occupancy.countIndex(shape.index(snakeHead)) > 1) gameOver = true; //head plus a body segment on the same cell
+}
+
+template <typename Shape>
+bool CollisionHandler::handle(SnakeSim& sim, const Shape& shape) {
+    SNAKE_PROFILE_SCOPE(Collision);
+    Cell snakeHead = sim.snakeBody.front(); //not at class level else it wont update every tick
+
+    foodCollisionHandle(sim, shape);
+    borderCollisionHandle(shape, snakeHead);
+    selfCollisionHandle(sim, shape, snakeHead);
+
+    return gameOver || boardFull;
+}
+
+struct SegmentPosition { //in cells, fractional while a segment slides between two ticks
+    float x;
+    float y;
+};
+
+template <typename Func>
+void forEachSegmentPosition(const SnakeSim& sim, float alpha, Func func) { //head to tail; alpha in [0, 1], how far render time is between the last tick and the next
+    //the per-segment half of drawing the snake, headless so the regression bench times exactly what Snake::Draw does
+    const SnakeBody& body = sim.body();
+    if (!sim.started()) alpha = 1; //nothing to interpolate from until the first tick
+
+    for (int i = 0; i < body.size(); i++) {
+        //each segment slides from where it was one tick ago, which is where its follower is now
+        Cell from = i + 1 < body.size() ? body[i + 1] : sim.lastTail();
+        Cell to = body[i];
+        func(SegmentPosition{from.x + (to.x - from.x) * alpha, from.y + (to.y - from.y) * alpha});
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+//structure-of-arrays backend for stepping many games in lockstep, an alternative to one SnakeSim per game
+//heads, headings and apples sit in parallel int16 arrays so next-head, border and apple checks run 16 games per AVX2 op (8 on NEON)
+//bodies, occupancy and spawns stay per game and scalar, they are already O(1) per tick
+//for the same seed and inputs every game plays out exactly like SnakeSim
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "SnakeSim.h"
+
+class SoABatch {
+private:
+    static constexpr int lanes = 16; //arrays are padded to a whole number of AVX2 registers
+
+    BoardSize board;
+    int gameCount;
+    int padded;
+
+    //lockstep state, one entry per game
+    std::vector<int16_t> headX, headY;
+    std::vector<int16_t> dirX, dirY;
+    std::vector<int16_t> inputX, inputY; //requested heading for the next tick
+    std::vector<int16_t> appleX, appleY;
+    std::vector<int16_t> alive; //0 or -1, an all-ones lane mask so kernels can blend with it directly
+
+    //kernel outputs, 0 or -1 per game
+    std::vector<int16_t> borderHit, appleHit;
+
+    //scalar per-game state
+    std::vector<SnakeBody> bodies;
+    std::vector<OccupancyGrid> grids;
+    std::vector<Rng> rngs;
+    std::vector<uint8_t> grow, won, hasApple;
+    std::vector<int> scores, lengths, ticks;
+
+    int liveGames;
+
+    static void headKernelScalar(BoardSize board, int begin, int end,
+        int16_t* hx, int16_t* hy, int16_t* dx, int16_t* dy, const int16_t* ix, const int16_t* iy,
+        const int16_t* ax, const int16_t* ay, const int16_t* live, int16_t* border, int16_t* ate)
+    {
+        for (int i = begin; i < end; i++) {
+            bool reverse = ix[i] + dx[i] == 0 && iy[i] + dy[i] == 0; //reversing into the neck is ignored, keep heading
+            if (!reverse) {
+                dx[i] = ix[i];
+                dy[i] = iy[i];
+            }
+
+            int16_t nx = hx[i] + dx[i];
+            int16_t ny = hy[i] + dy[i];
+
+            border[i] = (uint16_t(nx) >= board.cols || uint16_t(ny) >= board.rows) ? -1 : 0; //unsigned compare folds the < 0 check in
+            ate[i] = (nx == ax[i] && ny == ay[i]) ? -1 : 0;
+
+            if (live[i]) {
+                hx[i] = nx;
+                hy[i] = ny;
+            }
+        }
+    }
+
+#if defined(__AVX2__)
+    static void headKernelAVX2(BoardSize board, int count,
+        int16_t* hx, int16_t* hy, int16_t* dx, int16_t* dy, const int16_t* ix, const int16_t* iy,
+        const int16_t* ax, const int16_t* ay, const int16_t* live, int16_t* border, int16_t* ate)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i maxX = _mm256_set1_epi16(board.cols - 1);
+        const __m256i maxY = _mm256_set1_epi16(board.rows - 1);
+
+        for (int i = 0; i < count; i += lanes) {
+            auto load = [i](const int16_t* p) { return _mm256_loadu_si256((const __m256i*)(p + i)); };
+            auto store = [i](int16_t* p, __m256i v) { _mm256_storeu_si256((__m256i*)(p + i), v); };
+
+            __m256i curX = load(dx), curY = load(dy);
+            __m256i reqX = load(ix), reqY = load(iy);
+
+            __m256i reverse = _mm256_and_si256(
+                _mm256_cmpeq_epi16(_mm256_add_epi16(reqX, curX), zero),
+                _mm256_cmpeq_epi16(_mm256_add_epi16(reqY, curY), zero));
+            curX = _mm256_blendv_epi8(reqX, curX, reverse);
+            curY = _mm256_blendv_epi8(reqY, curY, reverse);
+            store(dx, curX);
+            store(dy, curY);
+
+            __m256i headsX = load(hx), headsY = load(hy);
+            __m256i nextX = _mm256_add_epi16(headsX, curX);
+            __m256i nextY = _mm256_add_epi16(headsY, curY);
+
+            //outside when below 0 or above the last row/col; no unsigned 16-bit compare in AVX2 so test both ends
+            __m256i outside = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpgt_epi16(zero, nextX), _mm256_cmpgt_epi16(nextX, maxX)),
+                _mm256_or_si256(_mm256_cmpgt_epi16(zero, nextY), _mm256_cmpgt_epi16(nextY, maxY)));
+            store(border, outside);
+
+            store(ate, _mm256_and_si256(_mm256_cmpeq_epi16(nextX, load(ax)), _mm256_cmpeq_epi16(nextY, load(ay))));
+
+            __m256i liveMask = load(live);
+            store(hx, _mm256_blendv_epi8(headsX, nextX, liveMask));
+            store(hy, _mm256_blendv_epi8(headsY, nextY, liveMask));
+        }
+    }
+#elif defined(__ARM_NEON)
+    static void headKernelNEON(BoardSize board, int count,
+        int16_t* hx, int16_t* hy, int16_t* dx, int16_t* dy, const int16_t* ix, const int16_t* iy,
+        const int16_t* ax, const int16_t* ay, const int16_t* live, int16_t* border, int16_t* ate)
+    {
+        const int16x8_t zero = vdupq_n_s16(0); //vceqzq is AArch64 only, this also builds for 32-bit Raspberry Pi
+        const uint16x8_t colLimit = vdupq_n_u16(board.cols);
+        const uint16x8_t rowLimit = vdupq_n_u16(board.rows);
+
+        for (int i = 0; i < count; i += 8) { //128-bit registers, two passes per padded block of 16
+            int16x8_t curX = vld1q_s16(dx + i), curY = vld1q_s16(dy + i);
+            int16x8_t reqX = vld1q_s16(ix + i), reqY = vld1q_s16(iy + i);
+
+            uint16x8_t reverse = vandq_u16(
+                vceqq_s16(vaddq_s16(reqX, curX), zero),
+                vceqq_s16(vaddq_s16(reqY, curY), zero));
+            curX = vbslq_s16(reverse, curX, reqX);
+            curY = vbslq_s16(reverse, curY, reqY);
+            vst1q_s16(dx + i, curX);
+            vst1q_s16(dy + i, curY);
+
+            int16x8_t headsX = vld1q_s16(hx + i), headsY = vld1q_s16(hy + i);
+            int16x8_t nextX = vaddq_s16(headsX, curX);
+            int16x8_t nextY = vaddq_s16(headsY, curY);
+
+            uint16x8_t outside = vorrq_u16( //unsigned compare folds the < 0 check in
+                vcgeq_u16(vreinterpretq_u16_s16(nextX), colLimit),
+                vcgeq_u16(vreinterpretq_u16_s16(nextY), rowLimit));
+            vst1q_s16(border + i, vreinterpretq_s16_u16(outside));
+
+            uint16x8_t hit = vandq_u16(vceqq_s16(nextX, vld1q_s16(ax + i)), vceqq_s16(nextY, vld1q_s16(ay + i)));
+            vst1q_s16(ate + i, vreinterpretq_s16_u16(hit));
+
+            uint16x8_t liveMask = vreinterpretq_u16_s16(vld1q_s16(live + i));
+            vst1q_s16(hx + i, vbslq_s16(liveMask, nextX, headsX));
+            vst1q_s16(hy + i, vbslq_s16(liveMask, nextY, headsY));
+        }
+    }
+#endif
+
+    void respawnApple(int game) {
+        OccupancyGrid& grid = grids[game];
+        hasApple[game] = grid.freeCount() > 0;
+        if (!hasApple[game]) return;
+
+        Cell pos = grid.freeCellPos(rngs[game].range(0, grid.freeCount() - 1));
+        appleX[game] = pos.x;
+        appleY[game] = pos.y;
+    }
+
+    void kill(int game) {
+        alive[game] = 0;
+        liveGames--;
+    }
+
+public:
+    SoABatch(int games, uint64_t seed, BoardSize board = defaultBoard) : //game i is seeded with seed + i, same as runBatch
+        board(board), gameCount(games), padded((games + lanes - 1) / lanes * lanes),
+        headX(padded), headY(padded), dirX(padded), dirY(padded), inputX(padded), inputY(padded),
+        appleX(padded, -1), appleY(padded, -1), alive(padded, 0), borderHit(padded), appleHit(padded),
+        rngs(games), grow(games, 0), won(games, 0), hasApple(games, 0), scores(games, 0), lengths(games, 2), ticks(games, 0),
+        liveGames(0)
+    {
+        bodies.reserve(games);
+        grids.reserve(games);
+
+        for (int game = 0; game < games; game++) {
+            bodies.emplace_back(board.cells());
+            grids.emplace_back(board.rows, board.cols);
+            reset(game, seed + game);
+        }
+    }
+
+    void reset(int game, uint64_t seed) { //starts that game over as SnakeSim(seed, board), reusing its body and grid
+        resetStart(bodies[game], grids[game], board);
+        rngs[game] = Rng(seed);
+
+        Cell start = toStep(Direction::Left);
+        headX[game] = bodies[game].front().x;
+        headY[game] = bodies[game].front().y;
+        dirX[game] = inputX[game] = start.x;
+        dirY[game] = inputY[game] = start.y;
+        if (!alive[game]) liveGames++;
+        alive[game] = -1;
+
+        grow[game] = won[game] = 0;
+        scores[game] = ticks[game] = 0;
+        lengths[game] = 2;
+
+        respawnApple(game);
+    }
+
+    int size() const { return gameCount; }
+    int running() const { return liveGames; }
+
+    void setInput(int game, Direction direction) {
+        Cell step = toStep(direction);
+        inputX[game] = step.x;
+        inputY[game] = step.y;
+    }
+
+    void step() { //one tick for every live game
+#if defined(__AVX2__)
+        headKernelAVX2(board, padded, headX.data(), headY.data(), dirX.data(), dirY.data(), inputX.data(), inputY.data(),
+            appleX.data(), appleY.data(), alive.data(), borderHit.data(), appleHit.data());
+#elif defined(__ARM_NEON)
+        headKernelNEON(board, padded, headX.data(), headY.data(), dirX.data(), dirY.data(), inputX.data(), inputY.data(),
+            appleX.data(), appleY.data(), alive.data(), borderHit.data(), appleHit.data());
+#else
+        headKernelScalar(board, 0, padded, headX.data(), headY.data(), dirX.data(), dirY.data(), inputX.data(), inputY.data(),
+            appleX.data(), appleY.data(), alive.data(), borderHit.data(), appleHit.data());
+#endif
+
+        for (int game = 0; game < gameCount; game++) {
+            if (!alive[game]) continue;
+            ticks[game]++;
+
+            if (borderHit[game]) {
+                kill(game);
+                continue;
+            }
+
+            SnakeBody& body = bodies[game];
+            OccupancyGrid& grid = grids[game];
+            Cell head = {headX[game], headY[game]};
+
+            if (grow[game]) grow[game] = 0;
+            else {
+                grid.release(body.back());
+                body.pop_back();
+            }
+            body.push_front(head);
+            grid.occupy(head);
+
+            if (appleHit[game] && hasApple[game]) {
+                respawnApple(game);
+                if (!hasApple[game]) won[game] = 1;
+                else { //the winning apple scores but has no cell left to grow into, as in SnakeSim
+                    grow[game] = 1;
+                    lengths[game]++;
+                }
+
+                scores[game] += 10;
+            }
+
+            if (won[game] || grid.count(head) > 1) kill(game);
+        }
+    }
+
+    class GameView {
+        //read-only window onto one game, quacks like SnakeSim for the batch policies
+        friend class SoABatch;
+
+    private:
+        const SoABatch* batch;
+        int game;
+
+        GameView(const SoABatch* batch, int game) : batch(batch), game(game) {}
+
+    public:
+        const SnakeBody& body() const { return batch->bodies[game]; }
+        const OccupancyGrid& grid() const { return batch->grids[game]; }
+        bool hasApple() const { return batch->hasApple[game]; }
+        Cell apple() const { return {batch->appleX[game], batch->appleY[game]}; }
+        bool growing() const { return batch->grow[game]; }
+
+        Direction heading() const {
+            int16_t x = batch->dirX[game], y = batch->dirY[game];
+            if (x) return x < 0 ? Direction::Left : Direction::Right;
+            return y < 0 ? Direction::Up : Direction::Down;
+        }
+
+        bool isOver() const { return !batch->alive[game]; }
+        bool isWon() const { return batch->won[game]; }
+        int score() const { return batch->scores[game]; }
+        int length() const { return batch->lengths[game]; }
+        int ticks() const { return batch->ticks[game]; }
+    };
+
+    GameView view(int game) const { return GameView(this, game); }
+};
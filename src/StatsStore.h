@@ -0,0 +1,413 @@
+#pragma once
+
+//persistent leaderboard and per difficulty totals, one record per finished game
+//record() only queues the game for a background writer, so the render loop never waits on the disk
+//the writer appends whatever queued up as one write and one fsync (a game that ends while a sync is running
+//rides along in the next batch), and once the log has grown far enough rewrites the file as just the totals
+//and the leaderboard, via a temp file renamed over the old one, so a crash at any point leaves a readable store
+//
+//file layout, all integers little endian, records checksummed so a write torn by a power cut is dropped on load:
+//  header   "SNKS" u16 version
+//  'G' u8 difficulty u8 won u16 rows u16 cols u64 seed u64 unixTime u32 score u32 length u32 ticks u32 check
+//      one game, appended
+//  'L' same fields, a leaderboard entry carried over by compaction, already counted in the totals
+//  'T' u8 difficulty u64 games u64 wins u64 totalScore u64 totalTicks u32 check, totals written by compaction
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Replay.h"
+#include "SnakeSim.h"
+
+struct GameRecord {
+    uint64_t seed = 0;
+    uint64_t unixTime = 0;
+    int32_t score = 0;
+    int32_t length = 0;
+    int32_t ticks = 0;
+    BoardSize board = defaultBoard;
+    uint8_t difficulty = 0; //GameSettings::Difficulty, kept as a number so this header stays free of the front-end
+    bool won = false;
+
+    static GameRecord of(const SnakeSim& sim, uint64_t seed, int ticks, int difficulty) {
+        GameRecord record;
+        record.seed = seed;
+        record.unixTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        record.score = sim.scores().getScore();
+        record.length = sim.scores().getLength();
+        record.ticks = ticks;
+        record.board = sim.boardSize();
+        record.difficulty = difficulty;
+        record.won = sim.collisions().isBoardFull();
+        return record;
+    }
+};
+
+struct StatsTotals {
+    uint64_t games = 0;
+    uint64_t wins = 0;
+    uint64_t totalScore = 0;
+    uint64_t totalTicks = 0;
+
+    double meanScore() const { return games ? double(totalScore) / games : 0; }
+};
+
+struct StatsFormat {
+    static constexpr char magic[4] = {'S', 'N', 'K', 'S'};
+    static constexpr uint16_t version = 1;
+    static constexpr int headerSize = 4 + 2;
+    static constexpr int difficulties = 3; //Easy, Medium, Hard
+    static constexpr int leaderboardSize = 10;
+
+    enum Record : uint8_t {Game = 'G', Leader = 'L', Totals = 'T'};
+
+    static uint32_t checksum(const uint8_t* data, size_t size) { //FNV-1a, enough to spot a torn or zeroed tail
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+        return hash;
+    }
+};
+
+class StatsTable {
+    //what the store holds in memory: totals and the top scores per difficulty, rebuilt from the file on load
+
+private:
+    StatsTotals totals[StatsFormat::difficulties];
+    std::vector<GameRecord> leaders[StatsFormat::difficulties]; //best first, at most leaderboardSize
+
+    static void sealed(std::vector<uint8_t>& out, size_t from) { //appends the checksum over out[from, end)
+        ByteWriter(out).u32(StatsFormat::checksum(out.data() + from, out.size() - from));
+    }
+
+public:
+    void rank(const GameRecord& game) { //onto the leaderboard if it makes the cut, ties keep the earlier game ahead
+        std::vector<GameRecord>& board = leaders[game.difficulty];
+        auto at = std::upper_bound(board.begin(), board.end(), game, [](const GameRecord& a, const GameRecord& b) { return a.score > b.score; });
+        if (at - board.begin() >= StatsFormat::leaderboardSize) return;
+
+        board.insert(at, game);
+        if (int(board.size()) > StatsFormat::leaderboardSize) board.pop_back();
+    }
+
+    void add(const GameRecord& game) {
+        StatsTotals& total = totals[game.difficulty];
+        total.games++;
+        total.wins += game.won;
+        total.totalScore += game.score;
+        total.totalTicks += game.ticks;
+        rank(game);
+    }
+
+    const StatsTotals& totalsFor(int difficulty) const { return totals[difficulty]; }
+    const std::vector<GameRecord>& leaderboard(int difficulty) const { return leaders[difficulty]; }
+    int best(int difficulty) const { return leaders[difficulty].empty() ? 0 : leaders[difficulty].front().score; }
+
+    static void writeGame(std::vector<uint8_t>& out, const GameRecord& game, StatsFormat::Record kind = StatsFormat::Game) {
+        size_t from = out.size();
+        ByteWriter writer(out);
+        writer.u8(kind);
+        writer.u8(game.difficulty);
+        writer.u8(game.won);
+        writer.u16(game.board.rows);
+        writer.u16(game.board.cols);
+        writer.u64(game.seed);
+        writer.u64(game.unixTime);
+        writer.u32(game.score);
+        writer.u32(game.length);
+        writer.u32(game.ticks);
+        sealed(out, from);
+    }
+
+    void writeCompacted(std::vector<uint8_t>& out) const { //a whole file holding this table and nothing else
+        ByteWriter writer(out);
+        writer.bytes((const uint8_t*)StatsFormat::magic, 4);
+        writer.u16(StatsFormat::version);
+
+        for (int difficulty = 0; difficulty < StatsFormat::difficulties; difficulty++) {
+            const StatsTotals& total = totals[difficulty];
+            if (total.games == 0) continue;
+
+            size_t from = out.size();
+            writer.u8(StatsFormat::Totals);
+            writer.u8(difficulty);
+            writer.u64(total.games);
+            writer.u64(total.wins);
+            writer.u64(total.totalScore);
+            writer.u64(total.totalTicks);
+            sealed(out, from);
+
+            for (const GameRecord& game : leaders[difficulty]) writeGame(out, game, StatsFormat::Leader);
+        }
+    }
+
+    size_t read(const uint8_t* data, size_t size) { //applies every whole record, returns where the good part ends, 0 if not a store
+        ByteReader reader(data, size);
+        const uint8_t* magic = reader.skip(4);
+        if (!magic || memcmp(magic, StatsFormat::magic, 4) != 0 || reader.u16() != StatsFormat::version) return 0;
+
+        size_t good = StatsFormat::headerSize;
+        while (!reader.atEnd()) {
+            const uint8_t* start = reader.cursor();
+            uint8_t kind = reader.u8();
+            uint8_t difficulty = reader.u8();
+
+            GameRecord game;
+            StatsTotals total;
+            if (kind == StatsFormat::Game || kind == StatsFormat::Leader) {
+                game.difficulty = difficulty;
+                game.won = reader.u8();
+                game.board.rows = reader.u16();
+                game.board.cols = reader.u16();
+                game.seed = reader.u64();
+                game.unixTime = reader.u64();
+                game.score = reader.u32();
+                game.length = reader.u32();
+                game.ticks = reader.u32();
+            }
+            else if (kind == StatsFormat::Totals) {
+                total.games = reader.u64();
+                total.wins = reader.u64();
+                total.totalScore = reader.u64();
+                total.totalTicks = reader.u64();
+            }
+            else break;
+
+            size_t body = reader.cursor() - start;
+            uint32_t check = reader.u32();
+            if (reader.failed() || difficulty >= StatsFormat::difficulties || check != StatsFormat::checksum(start, body)) break;
+
+            if (kind == StatsFormat::Game) add(game);
+            else if (kind == StatsFormat::Leader) rank(game);
+            else totals[difficulty] = total;
+            good = reader.cursor() - data;
+        }
+        return good;
+    }
+};
+
+class StatsStore {
+    //owns the file; the table the game reads is updated at once on the calling thread, the disk catches up behind it
+
+public:
+    struct WriterStats { //writer side counts, for tools and tuning
+        uint64_t written = 0;
+        uint64_t batches = 0; //one write and one fsync each
+        uint64_t compactions = 0;
+        uint64_t held = 0; //recorded but only in memory, the rewrite that would save them keeps failing
+    };
+
+private:
+    std::string path;
+    StatsTable shown; //calling thread only
+    bool opened = false;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<GameRecord> queued; //guarded by lock
+    bool stopping = false;
+    bool idle = true; //nothing queued and nothing being written, guarded by lock
+    std::condition_variable drained;
+    WriterStats published; //guarded by lock, copied from counts after every batch
+
+    //writer thread only
+    StatsTable durable; //what the file holds, the source for compaction
+    FILE* log = nullptr;
+    size_t logRecords = 0; //appended since the file was last compacted
+    bool compactNow = false; //load found a torn tail, rewrite before appending past it
+    std::vector<GameRecord> batch;
+    std::vector<uint8_t> bytes;
+    WriterStats counts;
+
+    std::thread writer; //last, so everything above exists before it starts
+
+    static constexpr size_t compactAfter = 4096; //log records, ~160KB; compacted files are a few hundred bytes
+
+    static bool syncFile(FILE* file) { //through to the device, fflush alone only reaches the OS
+        if (fflush(file) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    static bool syncDirectory(const std::string& file) { //a rename only survives a power cut once the directory entry is synced
+#if defined(_WIN32)
+        (void)file; //NTFS journals the rename itself, there is no directory handle to flush
+        return true;
+#else
+        std::string parent = std::filesystem::path(file).parent_path().string();
+        int dir = open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+        if (dir < 0) return false;
+        bool synced = fsync(dir) == 0;
+        close(dir);
+        return synced;
+#endif
+    }
+
+    bool compact() { //temp file synced then renamed over the log, the old file stays whole until the rename lands
+        std::string temp = path + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (!file) return false;
+
+        bytes.clear();
+        durable.writeCompacted(bytes);
+        bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && syncFile(file);
+        fclose(file);
+
+        std::error_code error;
+        if (written) {
+            if (log) fclose(log);
+            log = nullptr;
+            std::filesystem::rename(temp, path, error); //replaces the old file on Windows too
+        }
+        if (!written || error) {
+            std::filesystem::remove(temp, error);
+            if (!log) log = fopen(path.c_str(), "ab");
+            return false;
+        }
+
+        log = fopen(path.c_str(), "ab");
+        if (!syncDirectory(path)) return false; //the new file is in place but may not outlast a crash, rewrite again next batch
+
+        logRecords = 0;
+        counts.compactions++;
+        counts.written += counts.held; //in the totals the new file starts with
+        counts.held = 0;
+        return true;
+    }
+
+    void writeBatch() {
+        if (compactNow) compactNow = !compact(); //an earlier append may have torn, never append after it
+        if (compactNow) { //still cannot rewrite the file, hold the games for the compaction that finally works
+            for (const GameRecord& game : batch) durable.add(game);
+            counts.held += batch.size();
+            return;
+        }
+
+        bytes.clear();
+        for (const GameRecord& game : batch) StatsTable::writeGame(bytes, game);
+
+        if (log && fwrite(bytes.data(), 1, bytes.size(), log) == bytes.size() && syncFile(log)) {
+            for (const GameRecord& game : batch) durable.add(game);
+            logRecords += batch.size();
+            counts.written += batch.size();
+            counts.batches++;
+        }
+        else { //part of the batch may be on disk, a load would stop at it and drop every record appended after
+            for (const GameRecord& game : batch) durable.add(game); //kept for the compaction, which rewrites everything
+            counts.held += batch.size();
+            compactNow = true;
+        }
+
+        if (compactNow || logRecords >= compactAfter) compactNow = !compact();
+    }
+
+    void writerLoop() {
+        if (compactNow) compactNow = !compact();
+
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&] { return stopping || !queued.empty(); });
+            if (queued.empty()) break; //stopping, and everything queued is on disk
+
+            batch.swap(queued);
+            idle = false;
+            guard.unlock();
+
+            writeBatch();
+            batch.clear();
+
+            guard.lock();
+            published = counts;
+            idle = queued.empty();
+            if (idle) drained.notify_all();
+        }
+
+        if (log && logRecords > 0) compact(); //leave a small file behind for the next start
+        if (log) fclose(log);
+        log = nullptr;
+        published = counts;
+        idle = true;
+        drained.notify_all();
+    }
+
+public:
+    StatsStore(const char* path) : path(path) {
+        std::vector<uint8_t> existing;
+        if (ReplayReader::loadFile(path, existing) && !existing.empty()) {
+            size_t good = shown.read(existing.data(), existing.size());
+            if (good == 0) return; //not a stats file, never overwrite it
+
+            durable.read(existing.data(), existing.size());
+            compactNow = good < existing.size();
+            log = fopen(path, "ab");
+        }
+        else {
+            log = fopen(path, "wb");
+            if (log) {
+                bytes.clear();
+                durable.writeCompacted(bytes); //just the header
+                fwrite(bytes.data(), 1, bytes.size(), log);
+                syncFile(log);
+            }
+        }
+
+        opened = log != nullptr;
+        if (opened) writer = std::thread(&StatsStore::writerLoop, this);
+    }
+
+    ~StatsStore() {
+        if (!opened) return;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+
+    StatsStore(const StatsStore&) = delete;
+    StatsStore& operator=(const StatsStore&) = delete;
+
+    bool good() const { return opened; }
+
+    void record(const GameRecord& game) { //never touches the disk, O(1) plus the leaderboard insert
+        if (game.difficulty >= StatsFormat::difficulties) return;
+        shown.add(game);
+        if (!opened) return;
+
+        std::lock_guard<std::mutex> guard(lock);
+        queued.push_back(game);
+        idle = false;
+        wake.notify_one();
+    }
+
+    bool flush() { //blocks until the writer is idle, for tools; false if a recorded game is still only in memory
+        std::unique_lock<std::mutex> guard(lock);
+        drained.wait(guard, [&] { return idle; });
+        return opened && published.held == 0;
+    }
+
+    const StatsTable& table() const { return shown; }
+    WriterStats writerStats() { //as of the last finished batch
+        std::lock_guard<std::mutex> guard(lock);
+        return published;
+    }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+//work-stealing thread pool for the headless tools, every worker owns a queue and raids the others when it runs dry
+//plain C++ only, nothing here touches raylib
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+private:
+    using Task = std::function<void()>;
+
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Task> tasks; //owner pops the back (hot in cache), thieves take the front (oldest, biggest chunk of work left)
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepLock;
+    std::condition_variable wake; //signalled when work arrives or on shutdown
+    std::condition_variable idle; //signalled when the last pending task finishes
+
+    std::atomic<int> pending = 0; //submitted but not finished
+    std::atomic<unsigned> nextQueue = 0;
+    bool stopping = false;
+
+    static inline thread_local const ThreadPool* workerPool = nullptr; //lets a task submit to its own queue without contention
+    static inline thread_local int workerIndex = -1;
+
+    bool popLocal(int index, Task& task) {
+        WorkQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int thief, Task& task) {
+        for (size_t i = 1; i < queues.size(); i++) {
+            WorkQueue& victim = *queues[(thief + i) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.tasks.empty()) continue;
+
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(int index) {
+        workerPool = this;
+        workerIndex = index;
+        Task task;
+
+        while (true) {
+            if (popLocal(index, task) || steal(index, task)) {
+                task();
+                task = nullptr; //drop captures before signalling
+
+                if (--pending == 0) {
+                    std::lock_guard<std::mutex> guard(sleepLock);
+                    idle.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(sleepLock);
+            if (stopping) return;
+            wake.wait(guard, [&] { return stopping || hasQueuedWork(); });
+            if (stopping && !hasQueuedWork()) return;
+        }
+    }
+
+    bool hasQueuedWork() {
+        for (auto& queue : queues) {
+            std::lock_guard<std::mutex> guard(queue->lock);
+            if (!queue->tasks.empty()) return true;
+        }
+        return false;
+    }
+
+public:
+    ThreadPool(unsigned threadCount = std::thread::hardware_concurrency()) {
+        if (threadCount == 0) threadCount = 1; //hardware_concurrency may report 0 when unknown
+
+        for (unsigned i = 0; i < threadCount; i++) queues.push_back(std::make_unique<WorkQueue>());
+        for (unsigned i = 0; i < threadCount; i++) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ~ThreadPool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return workers.size(); }
+
+    void submit(Task task) {
+        pending++;
+
+        int index = workerPool == this ? workerIndex : nextQueue++ % queues.size(); //round robin from outside the pool
+        {
+            std::lock_guard<std::mutex> guard(queues[index]->lock);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+
+        std::lock_guard<std::mutex> guard(sleepLock); //taken so a worker between its check and its wait cannot miss this
+        wake.notify_one();
+    }
+
+    void wait() { //blocks until every submitted task, including ones submitted by tasks, has finished; never call from inside a task
+        std::unique_lock<std::mutex> guard(sleepLock);
+        idle.wait(guard, [&] { return pending == 0; });
+    }
+
+    template <typename Func>
+    void parallelFor(int begin, int end, int grain, Func func) { //func(first, last) over chunks of at most grain items
+        for (int first = begin; first < end; first += grain) {
+            int last = std::min(first + grain, end);
+            submit([=] { func(first, last); });
+        }
+        wait();
+    }
+};
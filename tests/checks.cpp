@@ -0,0 +1,348 @@
+//headless correctness checks for the plain C++ core, one function per invariant
+//prints every failed check and exits 1 if any failed, so make check can gate CI
+//usage: checks
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "Arena.h"
+#include "Autopilot.h"
+#include "BatchRunner.h"
+#include "NetProtocol.h"
+#include "Replay.h"
+#include "RegressionReport.h"
+#include "ReplayArchive.h"
+#include "StatsStore.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+static void winningLengthIsTheBoard() { //the last apple scores but there is no cell left to grow into
+    for (BoardSize board : {BoardSize{4, 4}, BoardSize{6, 6}, BoardSize{16, 16}}) {
+        SnakeSim sim(3, board);
+        Autopilot pilot(Autopilot::Mode::Cycle);
+        for (int tick = 0; tick < 1000000 && !sim.isOver(); tick++) sim.step(pilot.next(sim));
+
+        CHECK(sim.collisions().isBoardFull());
+        CHECK(sim.body().size() == board.cells());
+        CHECK(sim.scores().getLength() == board.cells());
+        CHECK(sim.scores().getScore() == (board.cells() - 1) * 10); //every apple after the first two segments, the winning one included
+    }
+}
+
+static std::vector<uint8_t> encode(const SnakeSim& sim) {
+    std::vector<uint8_t> bytes;
+    StateCodec::write(sim, bytes);
+    return bytes;
+}
+
+static void corruptKeyframesAreRejected() { //a keyframe whose fields contradict each other must never reach the sim
+    BoardSize board = defaultBoard;
+    constexpr int interval = 8;
+    SnakeSim sim(1, board);
+    ReplayWriter writer(1, board, interval);
+    GreedyPolicy policy;
+    Rng policyRng = policyStream(1);
+
+    for (int tick = 0; tick < 64 && !sim.isOver(); tick++) {
+        Direction input = policy(sim, policyRng);
+        sim.step(input);
+        writer.record(input, sim);
+    }
+    writer.finish(sim);
+    std::vector<uint8_t> bytes = writer.bytes();
+
+    //the first keyframe follows the header and one full input chunk
+    size_t keyframe = ReplayFormat::headerSize + 1 + 4 + 4 + interval / 4;
+    CHECK(bytes[keyframe] == ReplayFormat::Keyframe);
+    size_t state = keyframe + 1 + 4 + 4;
+    uint32_t stateSize = bytes[keyframe + 5] | bytes[keyframe + 6] << 8 | bytes[keyframe + 7] << 16 | bytes[keyframe + 8] << 24;
+    int length = bytes[state + 26] | bytes[state + 27] << 8; //after rng, direction, flags, apple, tail, score and length
+    size_t freeCount = state + 30 + 4 * length;
+
+    SnakeSim decoded(1, board);
+    CHECK(StateCodec::read(decoded, bytes.data() + state, stateSize));
+
+    std::vector<uint8_t> oneFreeCellShort = bytes;
+    oneFreeCellShort[freeCount]--; //the list still names free cells, just not all of them
+    CHECK(!StateCodec::read(decoded, oneFreeCellShort.data() + state, stateSize));
+
+    std::vector<uint8_t> tailOffBoard = bytes;
+    tailOffBoard[state + 30 + 4 * (length - 1)] = 0xff; //last segment x = -1
+    tailOffBoard[state + 30 + 4 * (length - 1) + 1] = 0xff;
+    CHECK(!StateCodec::read(decoded, tailOffBoard.data() + state, stateSize));
+
+    //seeking through a damaged keyframe falls back to stepping from the start and lands on the same state
+    ReplayReader clean(bytes.data(), bytes.size());
+    ReplayReader damaged(oneFreeCellShort.data(), oneFreeCellShort.size());
+    CHECK(clean.valid() && damaged.valid());
+    CHECK(encode(damaged.stateAt(12)) == encode(clean.stateAt(12)));
+
+    SnakeSim played = damaged.stateAt(12);
+    for (int tick = 12; tick < damaged.ticks(); tick++) played.step(damaged.input(tick)); //stepping on must stay in bounds
+    CHECK(played.scores().getScore() == damaged.recordedResult().score);
+}
+
+static void mirrorRejectsImpossibleDeltas() { //a bad or hostile delta stream must not walk the mirror's ring past its capacity
+    BoardSize board = {6, 6};
+    SnakeSim sim(5, board);
+    NetMirror mirror(board);
+    mirror.start(5);
+
+    NetProtocol::TickDelta::Before before = NetProtocol::TickDelta::capture(sim);
+    sim.step(sim.heading()); //onto the left border column, still alive
+    NetProtocol::TickDelta real = NetProtocol::TickDelta::between(before, sim);
+
+    NetProtocol::TickDelta jump = real;
+    jump.head.y += 2; //not next to the old head
+    CHECK(!mirror.apply(1, jump));
+
+    CHECK(mirror.apply(1, real));
+    CHECK(mirror.body().front() == sim.body().front());
+
+    NetProtocol::TickDelta offBoard = real;
+    offBoard.head.x -= 1; //past the border without the Over flag
+    CHECK(!mirror.apply(2, offBoard));
+
+    NetProtocol::TickDelta grow = real; //never moves the tail: the ring fills, then every further delta is refused
+    grow.flags &= ~NetProtocol::TickDelta::TailMoved;
+    uint32_t tick = 1;
+    int accepted = 0;
+    for (int i = 0; i < 2 * board.cells(); i++) {
+        Cell head = mirror.body().front();
+        grow.head = {int16_t(head.x == 0 ? 1 : 0), head.y};
+        if (mirror.apply(tick + 1, grow)) {
+            tick++;
+            accepted++;
+        }
+    }
+    CHECK(mirror.body().size() == board.cells());
+    CHECK(accepted == board.cells() - sim.body().size());
+}
+
+static void resetMatchesAFreshGame() { //a reused sim or batch game must replay exactly what a new one would
+    BoardSize board = {6, 6};
+    SnakeSim reused(3, board);
+    Autopilot pilot(Autopilot::Mode::Cycle);
+    for (int tick = 0; tick < 100000 && !reused.isOver(); tick++) reused.step(pilot.next(reused)); //dirty every field, win included
+    CHECK(reused.collisions().isBoardFull());
+
+    SoABatch batch(2, 3, board);
+    while (batch.running() > 0) batch.step(); //straight left into the border
+    CHECK(batch.view(0).isOver() && batch.view(1).isOver());
+
+    reused.reset(9);
+    batch.reset(0, 9);
+    CHECK(batch.running() == 1);
+
+    SnakeSim fresh(9, board);
+    GreedyPolicy policy;
+    Rng freshRng = policyStream(9), reusedRng = policyStream(9);
+    CHECK(encode(reused) == encode(fresh));
+
+    for (int tick = 0; tick < 1000 && !fresh.isOver(); tick++) {
+        Direction input = policy(fresh, freshRng);
+        CHECK(policy(reused, reusedRng) == input);
+        fresh.step(input);
+        reused.step(input);
+        batch.setInput(0, input);
+        batch.step();
+
+        CHECK(encode(reused) == encode(fresh));
+        CHECK(batch.view(0).body().front() == fresh.body().front());
+        CHECK(batch.view(0).score() == fresh.scores().getScore() && batch.view(0).isOver() == fresh.isOver());
+    }
+}
+
+static std::vector<uint8_t> greedyReplay(uint64_t seed, BoardSize board) {
+    SnakeSim sim(seed, board);
+    ReplayWriter writer(seed, board);
+    GreedyPolicy policy;
+    Rng policyRng = policyStream(seed);
+
+    while (!sim.isOver()) {
+        Direction input = policy(sim, policyRng);
+        sim.step(input);
+        writer.record(input, sim);
+    }
+    writer.finish(sim);
+    return writer.bytes();
+}
+
+static void archiveAppendsStayLinear() { //one game per commit must cost about one replay, not a fresh copy of the index
+    std::string path = (std::filesystem::temp_directory_path() / "snake_checks.snka").string();
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    uint64_t replayBytes = 0;
+    constexpr int games = 3000; //past the first index block, so one commit moves the index
+    for (int game = 0; game < games; game++) {
+        std::vector<uint8_t> replay = greedyReplay(game, {8, 8});
+        replayBytes += replay.size();
+
+        ReplayArchiveWriter writer(path.c_str());
+        CHECK(writer.good() && writer.append(replay) && writer.commit());
+    }
+
+    {
+        ReplayArchive archive(path.c_str());
+        CHECK(archive.valid() && archive.size() == games);
+        CHECK(archive.deadBytes() <= archive.indexCapacity() * sizeof(ArchiveEntry)); //at most the outgrown blocks
+        CHECK(std::filesystem::file_size(path) < replayBytes + 4 * games * sizeof(ArchiveEntry));
+    }
+
+    CHECK(ReplayArchiveWriter::compact(path.c_str()));
+    ReplayArchive compacted(path.c_str());
+    CHECK(compacted.valid() && compacted.size() == games && compacted.deadBytes() < alignof(ArchiveEntry));
+
+    ReplayReader reader;
+    ReplayReader::Result replayed;
+    CHECK(compacted.replay(games - 1, reader) && reader.verify(replayed));
+    std::filesystem::remove(path, error);
+}
+
+static void statsFlushReportsHeldGames() { //games the writer cannot get onto disk must not look synced
+    std::string path = (std::filesystem::temp_directory_path() / "snake_checks.snks").string();
+    std::filesystem::remove(path);
+    {
+        StatsStore store(path.c_str());
+        store.record(GameRecord::of(SnakeSim(1), 1, 0, 0));
+        CHECK(store.good() && store.flush());
+    }
+
+    FILE* file = fopen(path.c_str(), "ab");
+    fputc(StatsFormat::Game, file); //a torn record, the next start must rewrite before appending
+    fclose(file);
+    std::filesystem::create_directory(path + ".tmp"); //where the rewrite goes, so it keeps failing
+    {
+        StatsStore store(path.c_str());
+        store.record(GameRecord::of(SnakeSim(2), 2, 0, 0));
+        CHECK(!store.flush());
+        CHECK(store.writerStats().held == 1);
+
+        std::filesystem::remove(path + ".tmp");
+        store.record(GameRecord::of(SnakeSim(3), 3, 0, 0));
+        CHECK(store.flush());
+        CHECK(store.writerStats().held == 0 && store.writerStats().written == 2);
+    }
+
+    std::vector<uint8_t> bytes;
+    StatsTable table;
+    CHECK(ReplayReader::loadFile(path.c_str(), bytes) && table.read(bytes.data(), bytes.size()) == bytes.size());
+    std::filesystem::remove(path);
+}
+
+static void arenaSpawnsNeverHideApples() { //a respawn onto an apple would bury it under the body
+    ArenaConfig config;
+    config.board = {16, 16};
+    config.snakes = 12;
+    config.apples = 80; //crowded, so respawns keep landing next to apples
+    config.respawnDelay = 0;
+
+    Arena arena(11, config);
+    GreedyPolicy policy;
+    std::vector<Rng> policyRngs;
+    for (int id = 0; id < config.snakes; id++) policyRngs.push_back(policyStream(id));
+
+    int hidden = 0;
+    for (int tick = 0; tick < 5000; tick++) {
+        for (int id = 0; id < arena.snakeCount(); id++) {
+            if (arena.snake(id).alive()) arena.setInput(id, policy(arena.view(id), policyRngs[id]));
+        }
+        arena.step();
+        for (const Cell& apple : arena.apples()) hidden += arena.grid().occupied(apple);
+    }
+    CHECK(hidden == 0);
+}
+
+static void arenaCollisionRules() {
+    ArenaConfig config;
+    config.board = {8, 8};
+    config.snakes = 2;
+    config.apples = 0;
+    config.respawnDelay = -1;
+
+    auto scenario = [&](std::initializer_list<Cell> first, Direction firstHeading, std::initializer_list<Cell> second, Direction secondHeading) {
+        auto arena = std::make_unique<Arena>(1, config);
+        arena->clearApples();
+        arena->remove(0);
+        arena->remove(1); //off the board first, their random spawns could cover the scripted cells
+        CHECK(arena->place(0, first.begin(), first.size(), firstHeading));
+        CHECK(arena->place(1, second.begin(), second.size(), secondHeading));
+        arena->step();
+        return arena;
+    };
+
+    //head-on: both heads enter the same cell on the same tick, both die
+    auto headOn = scenario({{2, 3}, {1, 3}}, Direction::Right, {{4, 3}, {5, 3}}, Direction::Left);
+    CHECK(!headOn->snake(0).alive() && !headOn->snake(1).alive());
+
+    //a head may take the cell another snake's tail leaves this tick
+    auto followsTail = scenario({{2, 3}, {1, 3}}, Direction::Right, {{3, 1}, {3, 2}, {3, 3}}, Direction::Up);
+    CHECK(followsTail->snake(0).alive() && followsTail->snake(1).alive());
+    CHECK((followsTail->snake(0).body().front() == Cell{3, 3}));
+
+    //but not a cell the rest of the body still covers
+    auto hitsBody = scenario({{2, 3}, {1, 3}}, Direction::Right, {{3, 2}, {3, 3}, {3, 4}}, Direction::Up);
+    CHECK(!hitsBody->snake(0).alive() && hitsBody->snake(1).alive());
+
+    //and a snake may chase its own tail round a loop
+    auto ownTail = scenario({{1, 1}, {2, 1}, {2, 2}, {1, 2}}, Direction::Down, {{6, 6}, {6, 5}}, Direction::Down);
+    CHECK((ownTail->snake(0).alive() && ownTail->snake(0).body().front() == Cell{1, 2}));
+}
+
+static void benchBaselineRoundTrips() { //the gate reads bench.json back with string finds, a format change must not blind it
+    CaseResult replay;
+    replay.name = "replay 16x16";
+    replay.ticks = 2000000;
+    replay.seconds = 0.05;
+    replay.snakeMoves = replay.ticks;
+    replay.framed = true;
+    replay.frameP50 = 120;
+    replay.frameP99 = 480;
+    replay.frameMax = 9000;
+
+    CaseResult arena = replay;
+    arena.name = "arena 64x64 16 snakes";
+    arena.ticks = 20000;
+    arena.framed = false;
+
+    std::string json = toJson({replay, arena}, true);
+    CHECK(baselineValue(json, replay, "ticks_per_sec") == 40000000);
+    CHECK(baselineValue(json, replay, "frame_p50_ns") == 120);
+    CHECK(baselineValue(json, replay, "frame_p99_ns") == 480);
+    CHECK(baselineValue(json, arena, "ticks_per_sec") == 400000);
+    CHECK(baselineValue(json, arena, "frame_p50_ns") == 0); //arena cases are not framed, the key must not leak from the line above
+
+    CaseResult shorter = replay;
+    shorter.ticks = 1000;
+    CHECK(baselineValue(json, shorter, "ticks_per_sec") == 0);
+    CaseResult unknown = replay;
+    unknown.name = "replay 16";
+    CHECK(baselineValue(json, unknown, "ticks_per_sec") == 0);
+}
+
+int main() {
+    winningLengthIsTheBoard();
+    corruptKeyframesAreRejected();
+    mirrorRejectsImpossibleDeltas();
+    resetMatchesAFreshGame();
+    archiveAppendsStayLinear();
+    statsFlushReportsHeldGames();
+    arenaSpawnsNeverHideApples();
+    arenaCollisionRules();
+    benchBaselineRoundTrips();
+
+    if (failures) fprintf(stderr, "%d checks failed\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+//replay archive tool: builds archives from replay files or bot games, scans the index and pulls games back out
+//usage: archive add <archive> <replay>...
+//       archive generate <archive> [--games N] [--board RxC] [--seed N] [--policy random|greedy] [--max-ticks N]
+//       archive stats <archive>
+//       archive list <archive> [--top N]
+//       archive extract <archive> <game> <replay>
+//       archive verify <archive>
+//       archive compact <archive>   drops index blocks outgrown by earlier commits and any torn appends
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "BatchRunner.h"
+#include "ReplayArchive.h"
+
+static int usage() {
+    fprintf(stderr,
+        "usage: archive add <archive> <replay>...\n"
+        "       archive generate <archive> [--games N] [--board RxC] [--seed N] [--policy random|greedy] [--max-ticks N]\n"
+        "       archive stats <archive>\n"
+        "       archive list <archive> [--top N]\n"
+        "       archive extract <archive> <game> <replay>\n"
+        "       archive verify <archive>\n"
+        "       archive compact <archive>\n");
+    return 1;
+}
+
+template <typename Policy>
+static void recordGame(ReplayWriter& writer, BoardSize board, uint64_t seed, int maxTicks, Policy policy) {
+    SnakeSim sim(seed, board);
+    Rng policyRng = policyStream(seed);
+
+    for (int tick = 0; tick < maxTicks; tick++) {
+        Direction input = policy(sim, policyRng);
+        bool over = sim.step(input);
+        writer.record(input, sim);
+        if (over) break;
+    }
+    writer.finish(sim);
+}
+
+static int generate(ReplayArchiveWriter& archive, int argc, char** argv) {
+    int games = 1000;
+    BoardSize board = defaultBoard;
+    uint64_t seed = 1;
+    std::string policy = "greedy";
+    int maxTicks = 100000;
+
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--games")) games = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &board.rows, &board.cols);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--policy")) policy = argv[i + 1];
+        else if (!strcmp(argv[i], "--max-ticks")) maxTicks = atoi(argv[i + 1]);
+        else return usage();
+    }
+    if (!board.valid()) return usage();
+
+    for (int game = 0; game < games; game++) { //game i is seeded with seed + i, same as the batch runner
+        ReplayWriter writer(seed + game, board);
+        if (policy == "random") recordGame(writer, board, seed + game, maxTicks, RandomPolicy());
+        else recordGame(writer, board, seed + game, maxTicks, GreedyPolicy());
+
+        if (!archive.append(writer.bytes())) {
+            fprintf(stderr, "append failed at game %d\n", game);
+            return 1;
+        }
+    }
+
+    printf("archive now holds %llu games\n", (unsigned long long)archive.size());
+    return archive.commit() ? 0 : 1;
+}
+
+static int write(const char* path, const std::string& command, int argc, char** argv) {
+    ReplayArchiveWriter archive(path);
+    if (!archive.good()) {
+        fprintf(stderr, "cannot open %s for appending\n", path);
+        return 1;
+    }
+
+    if (command == "generate") return generate(archive, argc, argv);
+
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < argc; i++) {
+        if (!ReplayReader::loadFile(argv[i], bytes) || !archive.append(bytes)) {
+            fprintf(stderr, "skipping %s, not a readable replay\n", argv[i]);
+        }
+    }
+
+    printf("archive now holds %llu games\n", (unsigned long long)archive.size());
+    return archive.commit() ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    std::string command = argv[1];
+    const char* path = argv[2];
+
+    if (command == "add" || command == "generate") return write(path, command, argc - 3, argv + 3);
+    if (command == "compact") {
+        if (!ReplayArchiveWriter::compact(path)) {
+            fprintf(stderr, "cannot compact %s\n", path);
+            return 1;
+        }
+        printf("compacted %s\n", path);
+        return 0;
+    }
+
+    ReplayArchive archive(path);
+    if (!archive.valid()) {
+        fprintf(stderr, "%s: %s\n", path, archive.error());
+        return 1;
+    }
+
+    if (command == "stats") { //index only, never touches the replays themselves
+        auto start = std::chrono::steady_clock::now();
+
+        long long ticks = 0, totalScore = 0, wins = 0;
+        int maxScore = 0;
+        for (const ArchiveEntry& entry : archive) {
+            ticks += entry.ticks;
+            totalScore += entry.score;
+            maxScore = std::max(maxScore, entry.score);
+            wins += entry.won();
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t games = archive.size();
+
+        printf("games        %llu\n", (unsigned long long)games);
+        printf("ticks        %lld\n", ticks);
+        printf("score        mean %.1f max %d\n", games ? double(totalScore) / games : 0.0, maxScore);
+        printf("wins         %lld\n", wins);
+        printf("dead space   %llu bytes\n", (unsigned long long)archive.deadBytes());
+        printf("scan         %.3f ms\n", seconds * 1e3);
+        return 0;
+    }
+
+    if (command == "list") {
+        uint64_t top = archive.size();
+        if (argc >= 5 && !strcmp(argv[3], "--top")) top = std::min<uint64_t>(top, strtoull(argv[4], nullptr, 10));
+
+        std::vector<uint64_t> order(archive.size()); //best scores first
+        for (uint64_t i = 0; i < order.size(); i++) order[i] = i;
+        std::partial_sort(order.begin(), order.begin() + top, order.end(),
+            [&](uint64_t a, uint64_t b) { return archive.entry(a).score > archive.entry(b).score; });
+
+        printf("%10s %20s %7s %8s %7s %8s\n", "game", "seed", "board", "ticks", "score", "length");
+        for (uint64_t i = 0; i < top; i++) {
+            const ArchiveEntry& entry = archive.entry(order[i]);
+            printf("%10llu %20llu %3dx%-3d %8u %7d %8d\n", (unsigned long long)order[i], (unsigned long long)entry.seed,
+                entry.rows, entry.cols, entry.ticks, entry.score, entry.length);
+        }
+        return 0;
+    }
+
+    if (command == "extract") {
+        if (argc < 5) return usage();
+        uint64_t game = strtoull(argv[3], nullptr, 10);
+        if (game >= archive.size()) {
+            fprintf(stderr, "archive holds %llu games\n", (unsigned long long)archive.size());
+            return 1;
+        }
+
+        FILE* out = fopen(argv[4], "wb");
+        if (!out) return 1;
+        fwrite(archive.replayData(game), 1, archive.entry(game).size, out);
+        fclose(out);
+        return 0;
+    }
+
+    if (command == "verify") { //replays every game against its end record, one reader reused across the whole archive
+        ReplayReader reader;
+        ReplayReader::Result replayed;
+        uint64_t failures = 0;
+
+        for (uint64_t game = 0; game < archive.size(); game++) {
+            bool ok = archive.replay(game, reader) && reader.verify(replayed);
+            ok = ok && replayed.score == archive.entry(game).score && replayed.length == archive.entry(game).length;
+
+            if (!ok) {
+                failures++;
+                printf("game %llu does not reproduce its result\n", (unsigned long long)game);
+            }
+        }
+
+        printf("%llu of %llu games verified\n", (unsigned long long)(archive.size() - failures), (unsigned long long)archive.size());
+        return failures ? 2 : 0;
+    }
+
+    return usage();
+}
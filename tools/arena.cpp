@@ -0,0 +1,116 @@
+//headless multiplayer arena: many bot snakes on one large board, several arenas in parallel, prints throughput and outcomes
+//usage: arena [--board RxC] [--snakes N] [--apples N] [--arenas N] [--ticks N] [--threads N] [--seed N] [--policy random|greedy]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Arena.h"
+#include "BatchRunner.h"
+
+struct ArenaStats {
+    long long snakeTicks = 0; //live snake moves, the unit of work collision cost scales with
+    long long deaths = 0;
+    long long totalScore = 0;
+    int maxScore = 0;
+    int maxLength = 0;
+
+    void merge(const ArenaStats& other) {
+        snakeTicks += other.snakeTicks;
+        deaths += other.deaths;
+        totalScore += other.totalScore;
+        maxScore = std::max(maxScore, other.maxScore);
+        maxLength = std::max(maxLength, other.maxLength);
+    }
+};
+
+template <typename Policy>
+static ArenaStats playArena(uint64_t seed, const ArenaConfig& config, int ticks, Policy policy) {
+    Arena arena(seed, config);
+    std::vector<Rng> policyRngs; //stream per snake, so one snake's choices never shift another's
+    for (int id = 0; id < arena.snakeCount(); id++) policyRngs.push_back(policyStream(seed * 1024 + id));
+
+    ArenaStats stats;
+    for (int tick = 0; tick < ticks; tick++) {
+        for (int id = 0; id < arena.snakeCount(); id++) {
+            if (arena.snake(id).alive()) arena.setInput(id, policy(arena.view(id), policyRngs[id]));
+        }
+        stats.snakeTicks += arena.alive();
+        arena.step();
+    }
+
+    for (int id = 0; id < arena.snakeCount(); id++) {
+        const ArenaSnake& snake = arena.snake(id);
+        stats.deaths += snake.getDeaths();
+        stats.totalScore += snake.getScore();
+        stats.maxScore = std::max(stats.maxScore, snake.getScore());
+        stats.maxLength = std::max(stats.maxLength, snake.getLength());
+    }
+    return stats;
+}
+
+int main(int argc, char** argv) {
+    ArenaConfig config;
+    config.board = {256, 256};
+    config.snakes = 100;
+    config.apples = 64;
+
+    int arenas = 8;
+    int ticks = 10000;
+    unsigned threads = std::thread::hardware_concurrency();
+    uint64_t seed = 1;
+    std::string policy = "greedy";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &config.board.rows, &config.board.cols);
+        else if (!strcmp(argv[i], "--snakes")) config.snakes = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--apples")) config.apples = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--arenas")) arenas = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--ticks")) ticks = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--threads")) threads = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--policy")) policy = argv[i + 1];
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!config.board.valid() || config.snakes < 1 || config.apples < 0) {
+        fprintf(stderr, "board must be between %dx%d and %dx%d, with at least one snake\n",
+            BoardSize::minSide, BoardSize::minSide, BoardSize::maxSide, BoardSize::maxSide);
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<ArenaStats> arenaStats(arenas); //one slot per arena, merged after the join
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(0, arenas, 1, [&](int first, int last) {
+        for (int i = first; i < last; i++) {
+            arenaStats[i] = policy == "random" ? playArena(seed + i, config, ticks, RandomPolicy())
+                                               : playArena(seed + i, config, ticks, GreedyPolicy());
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ArenaStats total;
+    for (const ArenaStats& stats : arenaStats) total.merge(stats);
+    long long arenaTicks = (long long)arenas * ticks;
+    long long snakes = (long long)arenas * config.snakes;
+
+    printf("arenas       %d on %d threads (%dx%d board, %d snakes, %d apples, %s policy)\n",
+        arenas, pool.size(), config.board.rows, config.board.cols, config.snakes, config.apples, policy.c_str());
+    printf("ticks        %lld (%.0f arena ticks/sec)\n", arenaTicks, arenaTicks / seconds);
+    printf("snake moves  %lld (%.0f/sec, %.1f ns of cpu each)\n", total.snakeTicks, total.snakeTicks / seconds,
+        total.snakeTicks ? seconds * 1e9 * pool.size() / total.snakeTicks : 0.0);
+    printf("deaths       %lld\n", total.deaths);
+    printf("score        mean %.1f max %d\n", snakes ? double(total.totalScore) / snakes : 0.0, total.maxScore);
+    printf("length       max %d at the end\n", total.maxLength);
+    printf("elapsed      %.3f s\n", seconds);
+    return 0;
+}
@@ -0,0 +1,96 @@
+//asset baker: decodes and resizes images ahead of time and writes them as RLE-packed RGBA arrays into a C++ header
+//the game compiles that header in, so startup needs no Graphics/ folder and no PNG decoding
+//usage: bake_assets <out.h> --size N[,N...] <image>...
+//links raylib for LoadImage / ImageResize, the same code paths the game would otherwise run at startup
+
+#include <raylib.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "PixelRle.h"
+
+static std::string identifier(const std::string& path, int size) { //Graphics/Apple.png -> Graphics_Apple_png_50
+    std::string name;
+    for (char c : path) name += isalnum((unsigned char)c) ? c : '_';
+    return name + "_" + std::to_string(size);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 5 || strcmp(argv[2], "--size") != 0) {
+        fprintf(stderr, "usage: bake_assets <out.h> --size N[,N...] <image>...\n");
+        return 1;
+    }
+
+    const char* outPath = argv[1];
+    std::vector<int> sizes;
+    for (const char* p = argv[3]; *p; p++) {
+        sizes.push_back(atoi(p));
+        while (*p && *p != ',') p++;
+        if (!*p) break;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    FILE* out = fopen(outPath, "w");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+
+    fprintf(out, "#pragma once\n\n");
+    fprintf(out, "//generated by tools/bake_assets.cpp (make assets), do not edit\n");
+    fprintf(out, "//pre-decoded, pre-resized RGBA images, PixelRle coded\n\n");
+    fprintf(out, "struct PackedImage {\n    const char* path;\n    int width;\n    int height;\n    const unsigned char* data;\n    unsigned size;\n};\n\n");
+
+    struct Baked {
+        std::string path, name;
+        int size;
+        size_t bytes;
+    };
+    std::vector<Baked> baked;
+    size_t rawTotal = 0, packedTotal = 0;
+
+    for (int i = 4; i < argc; i++) {
+        Image source = LoadImage(argv[i]);
+        if (!source.data) {
+            fprintf(stderr, "cannot load %s\n", argv[i]);
+            fclose(out);
+            remove(outPath); //no half written pack, the game would fall back silently
+            return 1;
+        }
+
+        for (int size : sizes) {
+            Image image = ImageCopy(source);
+            ImageResize(&image, size, size);
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+            std::vector<uint8_t> packed = PixelRle::encode((const uint8_t*)image.data, size_t(size) * size);
+            std::string name = identifier(argv[i], size);
+
+            fprintf(out, "inline constexpr unsigned char %s[] = {", name.c_str());
+            for (size_t b = 0; b < packed.size(); b++) fprintf(out, "%s%u,", b % 24 == 0 ? "\n    " : "", packed[b]);
+            fprintf(out, "\n};\n\n");
+
+            baked.push_back({argv[i], name, size, packed.size()});
+            rawTotal += size_t(size) * size * 4;
+            packedTotal += packed.size();
+            UnloadImage(image);
+        }
+        UnloadImage(source);
+    }
+
+    fprintf(out, "inline constexpr PackedImage packedImages[] = {\n");
+    for (const Baked& image : baked) {
+        fprintf(out, "    {\"%s\", %d, %d, %s, %zu},\n", image.path.c_str(), image.size, image.size, image.name.c_str(), image.bytes);
+    }
+    fprintf(out, "};\n");
+    fclose(out);
+
+    printf("baked %zu images, %zu bytes raw, %zu packed\n", baked.size(), rawTotal, packedTotal);
+    return 0;
+}
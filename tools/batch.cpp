@@ -0,0 +1,69 @@
+//headless self-play farm: plays a batch of seeded games on every core and prints aggregate stats
+//usage: batch [--board RxC] [--games N] [--threads N] [--seed N] [--max-ticks N] [--policy random|greedy|path|cycle]
+//             [--backend scalar|soa]
+//path and cycle are the Autopilot modes, scalar backend only since they plan on the full SnakeSim
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Autopilot.h"
+#include "BatchRunner.h"
+
+int main(int argc, char** argv) {
+    BatchConfig config;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::string policy = "greedy";
+    std::string backend = "scalar";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &config.board.rows, &config.board.cols);
+        else if (!strcmp(argv[i], "--games")) config.games = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--threads")) threads = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seed")) config.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--max-ticks")) config.maxTicks = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--policy")) policy = argv[i + 1];
+        else if (!strcmp(argv[i], "--backend")) backend = argv[i + 1];
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!config.board.valid()) {
+        fprintf(stderr, "board must be between %dx%d and %dx%d\n", BoardSize::minSide, BoardSize::minSide, BoardSize::maxSide, BoardSize::maxSide);
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    BatchStats stats;
+
+    bool autopilot = policy == "path" || policy == "cycle";
+    if (autopilot && backend == "soa") {
+        fprintf(stderr, "the %s autopilot needs the scalar backend\n", policy.c_str());
+        return 1;
+    }
+
+    if (autopilot) stats = runBatch(pool, config, Autopilot(Autopilot::parse(policy)));
+    else if (backend == "soa") {
+        if (config.grain < 256) config.grain = 256; //lockstep pays off with wide chunks
+        stats = policy == "random" ? runSoABatch<RandomPolicy>(pool, config) : runSoABatch<GreedyPolicy>(pool, config);
+    }
+    else stats = policy == "random" ? runBatch<RandomPolicy>(pool, config) : runBatch<GreedyPolicy>(pool, config);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("games        %lld on %d threads (%dx%d board, %s policy, %s backend)\n",
+        stats.games, pool.size(), config.board.rows, config.board.cols, policy.c_str(), backend.c_str());
+    printf("ticks        %lld (%.0f ticks/sec)\n", stats.ticks, stats.ticks / seconds);
+    printf("score        mean %.1f max %d\n", stats.meanScore(), stats.maxScore);
+    printf("length       mean %.1f max %d\n", stats.meanLength(), stats.maxLength);
+    printf("wins         %lld\n", stats.wins);
+    printf("timeouts     %lld\n", stats.timeouts);
+    printf("elapsed      %.3f s\n", seconds);
+
+    return 0;
+}
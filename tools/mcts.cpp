@@ -0,0 +1,77 @@
+//MCTS agent runner: plays seeded games one after another, every decision searched across all cores, prints rollout
+//throughput next to the usual game stats so iteration budgets can be tuned against the Autopilot on the same seeds
+//usage: mcts [--board RxC] [--games N] [--threads N] [--seed N] [--max-ticks N] [--iterations N] [--horizon N]
+//            [--nodes N] [--exploration C] [--virtual-loss N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "BatchRunner.h"
+#include "Mcts.h"
+
+int main(int argc, char** argv) {
+    BatchConfig config;
+    config.games = 4;
+    config.maxTicks = 20000;
+    MctsConfig search;
+    unsigned threads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &config.board.rows, &config.board.cols);
+        else if (!strcmp(argv[i], "--games")) config.games = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--threads")) threads = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seed")) config.seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--max-ticks")) config.maxTicks = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--iterations")) search.iterations = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--horizon")) search.horizon = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--nodes")) search.maxNodes = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--exploration")) search.exploration = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--virtual-loss")) search.virtualLoss = atoi(argv[i + 1]);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!config.board.valid() || config.board.cells() > MctsAgent::maxCells) {
+        fprintf(stderr, "board must be between %dx%d and 256x256\n", BoardSize::minSide, BoardSize::minSide);
+        return 1;
+    }
+    if (search.iterations < 1 || search.horizon < 1 || search.maxNodes < 1 || search.virtualLoss < 0) {
+        fprintf(stderr, "iterations, horizon and nodes must be positive, virtual loss not negative\n");
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    MctsAgent agent(pool, search);
+    BatchStats stats;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int game = 0; game < config.games; game++) { //sequential, the pool is busy with each decision
+        uint64_t seed = config.seed + game;
+        SnakeSim sim(seed, config.board);
+        Rng policyRng = policyStream(seed);
+
+        int ticks = playGame(sim, agent, policyRng, config.maxTicks);
+        stats.add(sim, ticks);
+        printf("game %-6d score %-6d length %-6d ticks %-7d %s\n", game, sim.scores().getScore(), sim.scores().getLength(), ticks,
+            sim.collisions().isBoardFull() ? "won" : sim.isOver() ? "died" : "timeout");
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const MctsStats& searched = agent.stats();
+
+    printf("games        %lld on %d threads (%dx%d board, %d iterations, horizon %d)\n",
+        stats.games, pool.size(), config.board.rows, config.board.cols, search.iterations, search.horizon);
+    printf("decisions    %lld (%.3f ms each)\n", searched.decisions, searched.decisions ? searched.seconds * 1e3 / searched.decisions : 0.0);
+    printf("rollouts     %lld (%.0f rollouts/sec)\n", searched.rollouts, searched.rolloutsPerSecond());
+    printf("sim ticks    %lld (%.0f ticks/sec)\n", searched.ticks, searched.ticksPerSecond());
+    printf("tree         %.0f nodes per decision of %d\n", searched.decisions ? double(searched.nodes) / searched.decisions : 0.0, search.maxNodes);
+    printf("score        mean %.1f max %d\n", stats.meanScore(), stats.maxScore);
+    printf("length       mean %.1f max %d\n", stats.meanLength(), stats.maxLength);
+    printf("wins         %lld\n", stats.wins);
+    printf("timeouts     %lld\n", stats.timeouts);
+    printf("elapsed      %.3f s\n", seconds);
+    return 0;
+}
@@ -0,0 +1,436 @@
+//online play: the authoritative match server and a load generator of bot clients
+//usage: net server [--port N] [--tps N] [--max-matches N] [--timeout S]
+//       net bots <host:port> [--clients N] [--seconds S] [--board RxC] [--loss P] [--lead N] [--predict TPS]
+//the server runs one SnakeSim per joined client on a shared tick clock and sends each client only the deltas it lacks,
+//so hundreds of matches fit one thread; bots check every delta against their own copy of the sim
+//with --predict bots play through PredictedGame on their own clock and also check each confirmed tick after rollbacks
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "BatchRunner.h"
+#include "NetPrediction.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Match {
+    uint32_t session;
+    NetAddress client;
+    uint64_t seed;
+    SnakeSim sim;
+
+    uint32_t tick = 0; //steps taken
+    uint32_t ack = 0; //the newest tick the client has, it builds tick 0 from the seed itself
+    bool started = false; //ticks only once the client's first input shows it is listening
+    Clock::time_point lastHeard;
+
+    NetProtocol::TickDelta history[NetProtocol::historyTicks];
+    uint32_t inputTick[NetProtocol::historyTicks];
+    Direction input[NetProtocol::historyTicks];
+
+    long long lateInputs = 0;
+
+    Match(uint32_t session, NetAddress client, uint64_t seed, BoardSize board) :
+        session(session), client(client), seed(seed), sim(seed, board)
+    {
+        for (uint32_t& tag : inputTick) tag = NetProtocol::noTick;
+    }
+
+    void step() {
+        uint32_t next = tick + 1;
+        int slot = next % NetProtocol::historyTicks;
+        Direction chosen = inputTick[slot] == next ? input[slot] : sim.heading(); //missing input keeps going straight
+
+        NetProtocol::TickDelta::Before before = NetProtocol::TickDelta::capture(sim);
+        sim.step(chosen);
+        history[slot] = NetProtocol::TickDelta::between(before, sim);
+        tick = next;
+    }
+};
+
+class Server {
+private:
+    UdpSocket socket;
+    int tps;
+    size_t maxMatches;
+    double timeoutSeconds;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Match>> matches; //by session
+    std::unordered_map<uint64_t, uint32_t> sessionOf; //by client address, so a repeated hello gets the same match
+    Rng rng;
+
+    std::vector<uint8_t> packet;
+    uint8_t buffer[2048];
+    long long packetsIn = 0, packetsOut = 0, bytesOut = 0, ticksSent = 0, fullsSent = 0;
+
+    void transmit(const NetAddress& to) {
+        socket.send(to, packet.data(), packet.size());
+        packetsOut++;
+        bytesOut += packet.size();
+    }
+
+    void welcome(const Match& match) {
+        packet.clear();
+        ByteWriter writer(packet);
+        NetProtocol::header(writer, NetProtocol::Welcome, match.session);
+        writer.u16(match.sim.boardSize().rows);
+        writer.u16(match.sim.boardSize().cols);
+        writer.u64(match.seed);
+        writer.u16(tps);
+        transmit(match.client);
+    }
+
+    void hello(const NetAddress& from, ByteReader& reader) {
+        BoardSize board = {reader.u16(), reader.u16()};
+        if (reader.failed() || !NetProtocol::servable(board)) return;
+
+        auto known = sessionOf.find(from.key());
+        if (known != sessionOf.end()) return welcome(*matches[known->second]); //our welcome got lost
+        if (matches.size() >= maxMatches) return; //full, the client keeps asking
+
+        uint32_t session;
+        do session = rng.next();
+        while (session == 0 || matches.count(session));
+
+        uint64_t seed = uint64_t(rng.next()) << 32 | rng.next();
+        auto match = std::make_unique<Match>(session, from, seed, board);
+        match->lastHeard = Clock::now();
+        sessionOf[from.key()] = session;
+        welcome(*matches.emplace(session, std::move(match)).first->second);
+    }
+
+    void input(Match& match, ByteReader& reader) {
+        uint32_t ack = reader.u32();
+        uint32_t first = reader.u32();
+        int count = reader.u8();
+        Direction inputs[256];
+        if (!NetProtocol::unpackInputs(reader, inputs, count)) return;
+
+        match.started = true;
+        match.lastHeard = Clock::now();
+        if (ack != NetProtocol::noTick && ack <= match.tick && (match.ack == NetProtocol::noTick || ack > match.ack)) match.ack = ack;
+        else if (ack == NetProtocol::noTick) match.ack = ack; //client lost its state, it gets a full one
+
+        for (int i = 0; i < count; i++) {
+            uint32_t tick = first + i;
+            if (tick <= match.tick) { //already simulated, a redundant copy or genuinely late
+                if (tick == match.tick && match.history[tick % NetProtocol::historyTicks].applied() != inputs[i]) match.lateInputs++;
+                continue;
+            }
+            if (tick - match.tick > NetProtocol::historyTicks) break; //too far ahead to buffer
+            match.inputTick[tick % NetProtocol::historyTicks] = tick;
+            match.input[tick % NetProtocol::historyTicks] = inputs[i];
+        }
+    }
+
+    void receive() {
+        NetAddress from;
+        int size;
+        while ((size = socket.receive(from, buffer, sizeof(buffer))) > 0) {
+            packetsIn++;
+            ByteReader reader(buffer, size);
+            uint8_t type = reader.u8();
+            uint32_t session = reader.u32();
+            if (reader.failed()) continue;
+
+            if (type == NetProtocol::Hello) {
+                hello(from, reader);
+                continue;
+            }
+
+            auto found = matches.find(session);
+            if (found == matches.end() || !(found->second->client == from)) continue; //unknown or spoofed sender
+            Match& match = *found->second;
+
+            if (type == NetProtocol::Input) input(match, reader);
+            else if (type == NetProtocol::Bye) drop(session);
+        }
+    }
+
+    void drop(uint32_t session) {
+        auto found = matches.find(session);
+        if (found == matches.end()) return;
+        sessionOf.erase(found->second->client.key());
+        matches.erase(found);
+    }
+
+    void update(Match& match) { //whatever the client lacks: the oldest unacked deltas, or a full state if those are gone
+        if (match.ack != NetProtocol::noTick && match.ack >= match.tick) return;
+        packet.clear();
+        ByteWriter writer(packet);
+
+        if (match.ack == NetProtocol::noTick || match.tick - match.ack >= NetProtocol::historyTicks) {
+            NetProtocol::header(writer, NetProtocol::Full, match.session);
+            writer.u32(match.tick);
+            StateCodec::write(match.sim, packet);
+            fullsSent++;
+            return transmit(match.client);
+        }
+
+        int count = std::min<uint32_t>(NetProtocol::deltasPerPacket, match.tick - match.ack);
+        NetProtocol::header(writer, NetProtocol::Deltas, match.session);
+        writer.u32(match.ack + 1);
+        writer.u8(count);
+        for (int i = 1; i <= count; i++) match.history[(match.ack + i) % NetProtocol::historyTicks].write(writer);
+
+        ticksSent += count;
+        transmit(match.client);
+    }
+
+    void tickAll() {
+        Clock::time_point now = Clock::now();
+        std::vector<uint32_t> expired;
+
+        for (auto& [session, match] : matches) {
+            if (std::chrono::duration<double>(now - match->lastHeard).count() > timeoutSeconds) {
+                expired.push_back(session);
+                continue;
+            }
+            if (!match->started) continue;
+
+            if (!match->sim.isOver()) match->step();
+            update(*match);
+        }
+        for (uint32_t session : expired) drop(session);
+    }
+
+public:
+    Server(int tps, size_t maxMatches, double timeoutSeconds) :
+        tps(tps), maxMatches(maxMatches), timeoutSeconds(timeoutSeconds), rng(Clock::now().time_since_epoch().count()) {}
+
+    bool open(uint16_t port) { return socket.open(port); }
+
+    void run() {
+        Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tps));
+        Clock::time_point nextTick = Clock::now() + interval;
+        Clock::time_point nextReport = Clock::now() + std::chrono::seconds(5);
+
+        while (true) {
+            receive();
+
+            Clock::time_point now = Clock::now();
+            if (now >= nextTick) {
+                tickAll();
+                nextTick += interval;
+                if (nextTick < now) nextTick = now + interval; //fell behind, skip rather than burst
+            }
+
+            if (now >= nextReport) {
+                long long lateTotal = 0;
+                for (auto& entry : matches) lateTotal += entry.second->lateInputs;
+
+                printf("matches %zu  in %lld pkt  out %lld pkt %lld bytes  %.1f bytes per match tick  fulls %lld  late inputs %lld\n",
+                    matches.size(), packetsIn, packetsOut, bytesOut, ticksSent ? double(bytesOut) / ticksSent : 0.0, fullsSent, lateTotal);
+                fflush(stdout);
+                packetsIn = packetsOut = bytesOut = ticksSent = fullsSent = 0;
+                nextReport = now + std::chrono::seconds(5);
+            }
+
+            int waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(nextTick - Clock::now()).count();
+            if (waitMs > 0) socket.wait(waitMs);
+        }
+    }
+};
+
+static int serve(int argc, char** argv) {
+    uint16_t port = NetProtocol::defaultPort;
+    int tps = 10;
+    size_t maxMatches = 1000;
+    double timeout = 10;
+
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--port")) port = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--tps")) tps = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--max-matches")) maxMatches = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--timeout")) timeout = atof(argv[i + 1]);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (tps < 1) return 1;
+
+    Server server(tps, maxMatches, timeout);
+    if (!server.open(port)) {
+        fprintf(stderr, "cannot bind udp port %d\n", port);
+        return 1;
+    }
+    printf("serving on udp port %d at %d ticks/sec\n", port, tps);
+    fflush(stdout);
+    server.run();
+    return 0;
+}
+
+struct Bot {
+    NetClient client;
+    std::unique_ptr<SnakeSim> shadow; //stepped with the server's applied inputs, must agree with every delta
+    Rng policyRng;
+    uint32_t shadowTick = 0;
+    Clock::time_point lastSend;
+
+    std::unique_ptr<PredictedGame> game; //--predict only
+    double owed = 0; //seconds of local ticks due
+
+    Bot(uint64_t seed) : policyRng(policyStream(seed)) {}
+};
+
+static int bots(int argc, char** argv) {
+    if (argc < 1) return 1;
+    const char* address = argv[0];
+
+    int clients = 100;
+    double seconds = 10;
+    BoardSize board = defaultBoard;
+    double loss = 0;
+    int lead = 2; //ticks ahead of the last confirmed one an input is aimed at, covers the trip to the server
+    int predictTps = 0; //the server's rate, bots then tick locally and predict instead of following
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--clients")) clients = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seconds")) seconds = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &board.rows, &board.cols);
+        else if (!strcmp(argv[i], "--loss")) loss = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--lead")) lead = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--predict")) predictTps = atoi(argv[i + 1]);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<std::unique_ptr<Bot>> fleet;
+    for (int i = 0; i < clients; i++) {
+        fleet.push_back(std::make_unique<Bot>(i + 1));
+        fleet.back()->client.setLoss(loss);
+        if (!fleet.back()->client.connect(address, board)) {
+            fprintf(stderr, "cannot reach %s with a %dx%d board\n", address, board.rows, board.cols);
+            return 1;
+        }
+    }
+
+    long long games = 0, ticks = 0, mismatches = 0, resyncs = 0, totalScore = 0, rollbacks = 0, resimulated = 0;
+    GreedyPolicy policy;
+    Clock::time_point start = Clock::now(), last = start;
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    while (Clock::now() < end) {
+        Clock::time_point now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - last).count();
+        double clock = std::chrono::duration<double>(now - start).count();
+        last = now;
+
+        for (auto& bot : fleet) {
+            NetClient& client = bot->client;
+            if (bot->game) bot->game->reconcile();
+            else client.poll();
+            const std::vector<NetClient::Applied>& applied = client.lastPoll();
+
+            if (!client.joined()) {
+                client.send();
+                continue;
+            }
+            if (predictTps && !bot->game) {
+                bot->game = std::make_unique<PredictedGame>(client);
+                bot->owed = (1 + PredictedGame::leadTicks) / double(predictTps);
+            }
+
+            if (!bot->shadow) bot->shadow = std::make_unique<SnakeSim>(client.seed(), client.boardSize());
+            if (client.resynced()) {
+                *bot->shadow = client.resyncedState();
+                bot->shadowTick = client.state().lastTick();
+                resyncs++;
+            }
+
+            for (const NetClient::Applied& tick : applied) {
+                bot->shadow->step(tick.delta.applied());
+                bot->shadowTick = tick.tick;
+                ticks++;
+
+                const NetProtocol::TickDelta& delta = tick.delta;
+                bool agrees = bot->shadow->body().front() == delta.head
+                    && bot->shadow->isOver() == bool(delta.flags & NetProtocol::TickDelta::Over)
+                    && (!(delta.flags & NetProtocol::TickDelta::ScoreChanged) || bot->shadow->scores().getScore() == delta.score)
+                    && (!(delta.flags & NetProtocol::TickDelta::AppleMoved) || bot->shadow->apple() == delta.apple);
+                if (!agrees) mismatches++;
+            }
+
+            const NetMirror& state = client.state();
+            if (!applied.empty() && state.body().size() != bot->shadow->body().size()) mismatches++; //the mirror drifted from the deltas
+
+            if (bot->game && (!applied.empty() || client.resynced())) { //after any rollback the confirmed tick is the server's
+                const PredictedGame::Snapshot& confirmed = bot->game->confirmed();
+                bool agrees = confirmed.body[0] == bot->shadow->body().front() && Direction(confirmed.direction) == bot->shadow->heading()
+                    && confirmed.bodyLength == bot->shadow->body().size() && confirmed.score == bot->shadow->scores().getScore();
+                if (!agrees) mismatches++;
+            }
+
+            if (state.isOver()) { //game done, start another
+                games++;
+                totalScore += state.getScore();
+                if (bot->game) {
+                    rollbacks += bot->game->rollbacks();
+                    resimulated += bot->game->resimulated();
+                    bot->game.reset();
+                }
+                client.disconnect();
+                client.connect(address, board);
+                bot->shadow.reset();
+                client.send();
+                continue;
+            }
+
+            if (bot->game) { //local clock, the server's confirmations arrive a round trip later
+                bool advanced = false;
+                bot->owed += elapsed;
+                while (bot->owed >= 1.0 / predictTps && bot->game->canPredict() && !bot->game->predicted().isOver()) {
+                    bot->game->advance(policy(bot->game->predicted(), bot->policyRng));
+                    bot->owed -= 1.0 / predictTps;
+                    advanced = true;
+                }
+                bot->game->flush(clock, advanced);
+                continue;
+            }
+
+            bool news = !applied.empty() || client.resynced();
+            if (news) client.setInput(bot->shadowTick + lead, policy(*bot->shadow, bot->policyRng));
+            if (news || Clock::now() - bot->lastSend > std::chrono::milliseconds(100)) { //ack what arrived, else a keepalive
+                client.send();
+                bot->lastSend = Clock::now();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    long long sent = 0, received = 0;
+    for (auto& bot : fleet) {
+        sent += bot->client.bytesSent();
+        received += bot->client.bytesReceived();
+        if (bot->game) { //games still running
+            rollbacks += bot->game->rollbacks();
+            resimulated += bot->game->resimulated();
+        }
+    }
+
+    printf("clients      %d for %.1f s (%dx%d board, %.0f%% loss each way)\n", clients, seconds, board.rows, board.cols, loss * 100);
+    printf("games        %lld finished, mean score %.1f\n", games, games ? double(totalScore) / games : 0.0);
+    printf("ticks        %lld followed, %lld resyncs, %lld mismatches\n", ticks, resyncs, mismatches);
+    if (predictTps) printf("prediction   %lld rollbacks, %lld ticks re-simulated\n", rollbacks, resimulated);
+    printf("bandwidth    %.1f bytes down, %.1f up per client tick\n", ticks ? double(received) / ticks : 0.0, ticks ? double(sent) / ticks : 0.0);
+    return mismatches ? 2 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && !strcmp(argv[1], "server")) return serve(argc - 2, argv + 2);
+    if (argc >= 3 && !strcmp(argv[1], "bots")) return bots(argc - 2, argv + 2);
+
+    fprintf(stderr,
+        "usage: net server [--port N] [--tps N] [--max-matches N] [--timeout S]\n"
+        "       net bots <host:port> [--clients N] [--seconds S] [--board RxC] [--loss P] [--lead N] [--predict TPS]\n");
+    return 1;
+}
@@ -0,0 +1,160 @@
+//headless replay tool: records bot games, prints replay info, verifies recorded scores and plays replays back at any speed
+//usage: replay record <file> [--board RxC] [--seed N] [--policy random|greedy] [--max-ticks N] [--interval N]
+//       replay info <file>
+//       replay verify <file>
+//       replay play <file> [--from TICK] [--to TICK] [--tps N] [--repeat N]   (--tps 0 runs flat out)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "BatchRunner.h"
+#include "Replay.h"
+
+static int usage() {
+    fprintf(stderr,
+        "usage: replay record <file> [--board RxC] [--seed N] [--policy random|greedy] [--max-ticks N] [--interval N]\n"
+        "       replay info <file>\n"
+        "       replay verify <file>\n"
+        "       replay play <file> [--from TICK] [--to TICK] [--tps N] [--repeat N]\n");
+    return 1;
+}
+
+template <typename Policy>
+static void recordGame(ReplayWriter& writer, SnakeSim& sim, Policy policy, uint64_t seed, int maxTicks) {
+    Rng policyRng = policyStream(seed);
+    for (int tick = 0; tick < maxTicks; tick++) {
+        Direction input = policy(sim, policyRng);
+        bool over = sim.step(input);
+        writer.record(input, sim);
+        if (over) break;
+    }
+    writer.finish(sim);
+}
+
+static int record(const char* path, int argc, char** argv) {
+    BoardSize board = defaultBoard;
+    uint64_t seed = 1;
+    std::string policy = "greedy";
+    int maxTicks = 100000;
+    int interval = ReplayFormat::defaultKeyframeInterval;
+
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &board.rows, &board.cols);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--policy")) policy = argv[i + 1];
+        else if (!strcmp(argv[i], "--max-ticks")) maxTicks = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--interval")) interval = atoi(argv[i + 1]);
+        else return usage();
+    }
+    if (!board.valid() || interval <= 0) return usage();
+
+    ReplayWriter writer(path, seed, board, interval);
+    if (!writer.good()) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+
+    SnakeSim sim(seed, board);
+    if (policy == "random") recordGame(writer, sim, RandomPolicy(), seed, maxTicks);
+    else recordGame(writer, sim, GreedyPolicy(), seed, maxTicks);
+
+    printf("recorded %d ticks, score %d length %d\n", writer.recorded(), sim.scores().getScore(), sim.scores().getLength());
+    return 0;
+}
+
+static void printState(const char* label, const SnakeSim& sim, int tick) {
+    printf("%-9s tick %d score %d length %d%s\n", label, tick, sim.scores().getScore(), sim.scores().getLength(),
+        sim.collisions().isBoardFull() ? " (won)" : sim.isOver() ? " (over)" : "");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    std::string command = argv[1];
+    const char* path = argv[2];
+
+    if (command == "record") return record(path, argc - 3, argv + 3);
+
+    std::vector<uint8_t> bytes;
+    if (!ReplayReader::loadFile(path, bytes)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+
+    ReplayReader replay(bytes.data(), bytes.size());
+    if (!replay.valid()) {
+        fprintf(stderr, "%s: %s\n", path, replay.error());
+        return 1;
+    }
+
+    if (command == "info") {
+        printf("board     %dx%d\n", replay.boardSize().rows, replay.boardSize().cols);
+        printf("seed      %llu\n", (unsigned long long)replay.seed());
+        printf("ticks     %d (%zu bytes, %.2f bits/tick)\n", replay.ticks(), bytes.size(), replay.ticks() ? bytes.size() * 8.0 / replay.ticks() : 0.0);
+        printf("keyframes %d every %d ticks\n", replay.keyframeCount(), replay.interval());
+        if (replay.finished()) {
+            const ReplayReader::Result& result = replay.recordedResult();
+            printf("result    score %d length %d%s\n", result.score, result.length, result.won ? " (won)" : result.over ? " (over)" : "");
+        }
+        else printf("result    none, recording was cut short\n");
+        return 0;
+    }
+
+    if (command == "verify") {
+        ReplayReader::Result replayed;
+        bool match = replay.verify(replayed);
+        printf("replayed  score %d length %d over %d ticks\n", replayed.score, replayed.length, replayed.ticks);
+        if (!replay.finished()) printf("no end record to verify against\n");
+        else printf("%s\n", match ? "verified" : "MISMATCH with the recorded result");
+        return match ? 0 : 2;
+    }
+
+    if (command == "play") {
+        int from = 0, to = replay.ticks(), repeat = 1;
+        double tps = 0;
+
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "--from")) from = atoi(argv[i + 1]);
+            else if (!strcmp(argv[i], "--to")) to = atoi(argv[i + 1]);
+            else if (!strcmp(argv[i], "--tps")) tps = atof(argv[i + 1]);
+            else if (!strcmp(argv[i], "--repeat")) repeat = atoi(argv[i + 1]);
+            else return usage();
+        }
+        from = std::clamp(from, 0, replay.ticks());
+        to = std::clamp(to, from, replay.ticks());
+
+        using Clock = std::chrono::steady_clock;
+        Clock::duration tickPeriod = tps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / tps)) : Clock::duration(0);
+
+        auto start = Clock::now();
+        long long ticks = 0;
+        SnakeSim sim = replay.start();
+
+        for (int round = 0; round < repeat; round++) {
+            sim = replay.stateAt(from); //seek: nearest keyframe at or before from, then step
+            if (round == 0) printState("from", sim, from);
+
+            auto next = Clock::now();
+            for (int tick = from; tick < to; tick++) {
+                sim.step(replay.input(tick));
+                ticks++;
+
+                if (tps > 0) {
+                    next += tickPeriod;
+                    std::this_thread::sleep_until(next);
+                    printState("", sim, tick + 1);
+                }
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        printState("to", sim, to);
+        printf("played    %lld ticks in %.3f s (%.0f ticks/sec)\n", ticks, seconds, seconds > 0 ? ticks / seconds : 0.0);
+        return 0;
+    }
+
+    return usage();
+}
@@ -0,0 +1,107 @@
+//stats store inspector and load generator
+//usage: stats show <file.snks>
+//       stats fill <file.snks> [--games N] [--board RxC] [--seed N]   plays greedy games and records each one
+//fill measures what the render loop would feel (the cost of record()) next to how the writer batched and synced
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "BatchRunner.h"
+#include "StatsStore.h"
+
+static const char* difficultyNames[StatsFormat::difficulties] = {"Easy", "Medium", "Hard"};
+
+static void show(const StatsTable& table) {
+    for (int difficulty = 0; difficulty < StatsFormat::difficulties; difficulty++) {
+        const StatsTotals& total = table.totalsFor(difficulty);
+        if (total.games == 0) continue;
+
+        printf("%-8s games %llu  wins %llu  mean score %.1f  ticks %llu\n", difficultyNames[difficulty],
+            (unsigned long long)total.games, (unsigned long long)total.wins, total.meanScore(), (unsigned long long)total.totalTicks);
+        int rank = 1;
+        for (const GameRecord& game : table.leaderboard(difficulty)) {
+            printf("  %2d. %-6d length %-5d %dx%d seed %llu%s\n", rank++, game.score, game.length, game.board.rows, game.board.cols,
+                (unsigned long long)game.seed, game.won ? " won" : "");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: stats show|fill <file.snks> [options]\n");
+        return 1;
+    }
+    std::string command = argv[1];
+    const char* path = argv[2];
+
+    if (command == "show") {
+        std::vector<uint8_t> bytes;
+        StatsTable table;
+        if (!ReplayReader::loadFile(path, bytes) || table.read(bytes.data(), bytes.size()) == 0) {
+            fprintf(stderr, "%s is not a stats store\n", path);
+            return 1;
+        }
+        show(table);
+        return 0;
+    }
+
+    if (command != "fill") {
+        fprintf(stderr, "unknown command %s\n", command.c_str());
+        return 1;
+    }
+
+    int games = 10000;
+    BoardSize board = defaultBoard;
+    uint64_t seed = 1;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--games")) games = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--board")) sscanf(argv[i + 1], "%dx%d", &board.rows, &board.cols);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoull(argv[i + 1], nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!board.valid()) {
+        fprintf(stderr, "board must be between %dx%d and %dx%d\n", BoardSize::minSide, BoardSize::minSide, BoardSize::maxSide, BoardSize::maxSide);
+        return 1;
+    }
+
+    StatsStore store(path);
+    if (!store.good()) {
+        fprintf(stderr, "cannot open %s as a stats store\n", path);
+        return 1;
+    }
+
+    GreedyPolicy policy;
+    double recordSeconds = 0, worstRecord = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < games; i++) {
+        SnakeSim sim(seed + i, board);
+        Rng policyRng = policyStream(seed + i);
+        int ticks = playGame(sim, policy, policyRng, 100000);
+
+        auto before = std::chrono::steady_clock::now();
+        store.record(GameRecord::of(sim, seed + i, ticks, i % StatsFormat::difficulties));
+        double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+        recordSeconds += took;
+        worstRecord = std::max(worstRecord, took);
+    }
+    bool synced = store.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    StatsStore::WriterStats written = store.writerStats();
+
+    show(store.table());
+    printf("recorded     %d games in %.3f s\n", games, seconds);
+    printf("record()     mean %.2f us, worst %.2f us\n", games ? recordSeconds * 1e6 / games : 0.0, worstRecord * 1e6);
+    printf("written      %llu games in %llu batches (one fsync each), %llu compactions\n",
+        (unsigned long long)written.written, (unsigned long long)written.batches, (unsigned long long)written.compactions);
+    if (!synced) {
+        fprintf(stderr, "%llu games are not on disk, %s cannot be rewritten\n", (unsigned long long)written.held, path);
+        return 1;
+    }
+    return 0;
+}